@@ -0,0 +1,66 @@
+// ==========================================================================
+// Sphere generation micro-benchmark
+//
+// Times the planet sphere generation for n = 32 to 2048 rings: the vertex
+// and index fill on one thread and on every hardware thread, and the full
+// planetMaker call including the allocation of its vectors. The ACMR of the
+// generated triangle order is printed alongside.
+//
+// Usage: spherebench.out [max n]
+// ==========================================================================
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "mesh.h"
+
+using namespace std;
+using namespace glm;
+
+#define MIN_SEGMENTS 32
+#define MAX_SEGMENTS 2048
+#define REPEATS 3		// Best of, the first run also pays for page faults
+
+// milliseconds taken by the fastest of REPEATS calls
+template<typename F> static double BestTime(F run){
+	double best = 1e30;
+	for(int r = 0; r<REPEATS; r++){
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		run();
+		chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+		if(elapsed.count() < best) best = elapsed.count();
+	}
+	return best;
+}
+
+int main(int argc, char *argv[])
+{
+	int maxSegments = argc > 1 ? atoi(argv[1]) : MAX_SEGMENTS;
+	int threads = std::max(1u, thread::hardware_concurrency());
+
+	cout << "Sphere generation, best of " << REPEATS << ", " << threads << " hardware threads" << endl;
+	cout << setw(6) << "n" << setw(12) << "triangles" << setw(14) << "fill 1t ms"
+		<< setw(14) << "fill mt ms" << setw(16) << "planetMaker ms" << setw(8) << "ACMR" << endl;
+
+	for(int n = MIN_SEGMENTS; n<=maxSegments; n *= 2){
+		vector<vec3> sphere(SphereVertexCount(n));
+		vector<vec2> texCoord(SphereVertexCount(n));
+		vector<GLuint> indices(SphereIndexCount(n));
+
+		double single = BestTime([&](){ FillSphere(sphere.data(), texCoord.data(), indices.data(), 0, n, 1); });
+		double multi = BestTime([&](){ FillSphere(sphere.data(), texCoord.data(), indices.data(), 0, n, threads); });
+		double full = BestTime([&](){
+			vector<vec3> planet;
+			vector<vec2> planetTex;
+			vector<GLuint> planetIndices;
+			planetMaker(&planet, &planetTex, &planetIndices, n);
+		});
+
+		cout << fixed << setprecision(2) << setw(6) << n << setw(12) << indices.size()/3 << setw(14) << single
+			<< setw(14) << multi << setw(16) << full << setw(8) << ComputeACMR(indices) << endl;
+	}
+	return 0;
+}
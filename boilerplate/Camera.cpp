@@ -13,6 +13,34 @@ glm::mat4 Camera::viewMatrix() const{
 	return glm::lookAt(pos, centre, up);
 }
 
+Frustum Camera::frustum(const mat4& perspectiveMatrix) const{
+	// each plane is a sum or difference of the rows of the view projection
+	// (Gribb and Hartmann), glm matrices are indexed by column
+	mat4 m = transpose(perspectiveMatrix*viewMatrix());
+	Frustum frustum;
+	frustum.planes[0] = m[3] + m[0];
+	frustum.planes[1] = m[3] - m[0];
+	frustum.planes[2] = m[3] + m[1];
+	frustum.planes[3] = m[3] - m[1];
+	frustum.planes[4] = m[3] + m[2];
+	frustum.planes[5] = m[3] - m[2];
+	for(int i = 0; i < 6; i++)
+		frustum.planes[i] /= length(vec3(frustum.planes[i]));
+	return frustum;
+}
+
+bool Frustum::intersects(const BoundingSphere& sphere) const{
+	for(int i = 0; i < 6; i++){
+		if(dot(vec3(planes[i]), sphere.centre) + planes[i].w < -sphere.radius) return false;
+	}
+	return true;
+}
+
+BoundingSphere WorldBounds(const mat4& modelMatrix, float modelRadius){
+	BoundingSphere sphere = {vec3(modelMatrix[3]), modelRadius*length(vec3(modelMatrix[0]))};
+	return sphere;
+}
+
 void Camera::rotateVertical(float radians){
 	mat4 rotationMatrix = glm::rotate(mat4(1.f), radians, right);
 	vec3 newDir = normalize(vec3(rotationMatrix*vec4(dir, 0)));
@@ -1,5 +1,27 @@
+#pragma once
 #include <glm/glm.hpp>
 
+//Sphere in world space bounding something drawn
+struct BoundingSphere
+{
+	glm::vec3 centre;
+	float radius;
+};
+
+//Bounds of a model whose geometry fits in a sphere of the given radius around
+//its origin, the model matrix must scale uniformly
+BoundingSphere WorldBounds(const glm::mat4& modelMatrix, float modelRadius);
+
+//Planes of a view frustum in world space, each (normal, distance) with the
+//normal pointing inside: left, right, bottom, top, near, far
+struct Frustum
+{
+	glm::vec4 planes[6];
+
+	//True if any part of the sphere may be inside
+	bool intersects(const BoundingSphere& sphere) const;
+};
+
 class Camera{
 public:
 	glm::vec3 dir, right, up, pos, centre;
@@ -17,4 +39,6 @@ public:
 	void rotateVertical(float radians);
 	void rotateHorizontal(float radians);
 	void move(glm::vec3 movement);		//Moves in rotated frame
-};
\ No newline at end of file
+
+	Frustum frustum(const glm::mat4& perspectiveMatrix) const;	//Frustum of the view through a projection
+};
@@ -16,6 +16,7 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <cfloat>
 #include <string>
 #include <iterator>
 #include <glm/glm.hpp>
@@ -27,6 +28,20 @@
 
 #include "texture.h"
 #include "Camera.h"
+#include "geometry.h"
+#include "mesh.h"
+#include "meshregistry.h"
+#include "instancing.h"
+#include "lod.h"
+#include "framestats.h"
+#include "terrain.h"
+#include "shaderprogram.h"
+#include "material.h"
+#include "uniformblocks.h"
+#include "renderqueue.h"
+#include "indirect.h"
+#include "occlusion.h"
+#include "programcache.h"
 #include <vector>
 
 using namespace std;
@@ -39,9 +54,9 @@ using namespace glm;
 void QueryGLVersion();
 bool CheckGLErrors();
 
-string LoadSource(const string &filename);
+string LoadSource(const string &filename, const string &defines = "");
 GLuint CompileShader(GLenum shaderType, const string &source);
-GLuint LinkProgram(GLuint vertexShader, GLuint fragmentShader);
+GLuint LinkProgram(GLuint vertexShader, GLuint fragmentShader, GLuint controlShader = 0, GLuint evaluationShader = 0);
 
 bool lbPushed = false;
 
@@ -51,7 +66,6 @@ float ROTATION_SCALER = 50.f;
 #define PLANET_SIZE_SCALER 24.f
 #define PLANET_REVO_SCALER 1.f
 #define PLANET_REVO_RADIUS_SCALER 500.f
-#define SCALER_STAR 10.f
 
 float SCALER_SUN = 0.1f;//8/PLANET_SIZE_SCALER;
 float SCALER_JUPITER = 2/PLANET_SIZE_SCALER;//6.9/PLANET_SIZE_SCALER;
@@ -103,18 +117,63 @@ float cam_phi, cam_theta;
 Camera cam;
 
 
+// layers of the texture array used by instanced rendering
+enum TextureLayer{
+	LAYER_SUN, LAYER_EARTH, LAYER_EARTH_NIGHT, LAYER_EARTH_SPEC, LAYER_MOON, LAYER_MARS,
+	LAYER_VENUS, LAYER_MERCURY, LAYER_JUPITER, LAYER_SATURN, LAYER_URANUS, LAYER_NEPTUNE,
+	LAYER_COUNT
+};
+const char* LAYER_FILES[LAYER_COUNT] = {
+	"2k_sun.jpg", "2k_earth_daymap.jpg", "2k_earth_nightmap.jpg", "spec.jpg", "2k_moon.jpg", "2k_mars.jpg",
+	"2k_venus_atmosphere.jpg", "2k_mercury.jpg", "2k_jupiter.jpg", "2k_saturn.jpg", "2k_uranus.jpg", "2k_neptune.jpg"
+};
+
+// spherical bodies, in the order of the instance array
+enum Body{
+	BODY_SUN, BODY_EARTH, BODY_MOON, BODY_MARS, BODY_MERCURY,
+	BODY_VENUS, BODY_JUPITER, BODY_SATURN, BODY_URANUS, BODY_NEPTUNE,
+	BODY_COUNT
+};
+
+// slots of the object uniform block, one per body, the ring shares Saturn's
+#define OBJECT_COUNT BODY_COUNT
+
+#define SKY_FACE_SIZE 2048		// faces of the star background cube map, about the equator resolution of the 8k panorama
+
+// body the camera orbits in every planet_mode
+const Body MODE_BODIES[10] = {
+	BODY_NEPTUNE, BODY_SUN, BODY_MERCURY, BODY_VENUS, BODY_EARTH,
+	BODY_MOON, BODY_MARS, BODY_JUPITER, BODY_SATURN, BODY_URANUS
+};
+
+#define WINDOW_TITLE "CPSC 453 OpenGL Boilerplate"
+
+// generator building the planet spheres, picked on the command line
+const MeshGenerator* sphere_generator = nullptr;
+
 int planet_mode = 1;
+int instanced_flg = 1;		// draw the spherical bodies with one instanced draw call
+int procedural_flg = 0;		// build the spheres in the vertex shader, without vertex buffers
+int tessellated_flg = 0;	// refine a coarse sphere in tessellation shaders
+int terrain_flg = 0;		// draw the body the camera orbits from chunked terrain, for close-ups
+int occlusion_flg = 1;		// skip the bodies hidden behind others, found by occlusion queries
 // --------------------------------------------------------------------------
 // Functions to set up OpenGL shader programs for rendering
 
-// load, compile, and link shaders, returning true if successful
-GLuint InitializeShaders()
+// load, compile, and link shaders, returning true if successful, the defines
+// select a variant of the sources. A program linked before from the same
+// sources comes from the program binary cache instead
+GLuint InitializeShaders(const string &vertexFile = "shaders/vertex.glsl", const string &fragmentFile = "shaders/fragment.glsl",
+						 const string &defines = "")
 {
 	// load shader source from files
-	string vertexSource = LoadSource("shaders/vertex.glsl");
-	string fragmentSource = LoadSource("shaders/fragment.glsl");
+	string vertexSource = LoadSource(vertexFile, defines);
+	string fragmentSource = LoadSource(fragmentFile, defines);
 	if (vertexSource.empty() || fragmentSource.empty()) return false;
 
+	string key = ProgramCacheKey({vertexSource, fragmentSource});
+	if (GLuint cached = LoadCachedProgram(key)) return cached;
+
 	// compile shader source into shader objects
 	GLuint vertex = CompileShader(GL_VERTEX_SHADER, vertexSource);
 	GLuint fragment = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
@@ -125,196 +184,40 @@ GLuint InitializeShaders()
 	glDeleteShader(vertex);
 	glDeleteShader(fragment);
 
-	// check for OpenGL errors and return false if error occurred
-	return program;
-}
-
-// --------------------------------------------------------------------------
-// Functions to set up OpenGL buffers for storing geometry data
-
-struct Geometry
-{
-	// OpenGL names for array buffer objects, vertex array object
-	GLuint  vertexBuffer;
-	GLuint  textureBuffer;
-	GLuint  colourBuffer;
-	GLuint  vertexArray;
-	GLsizei elementCount;
-
-	// initialize object names to zero (OpenGL reserved value)
-	Geometry() : vertexBuffer(0), colourBuffer(0), vertexArray(0), elementCount(0)
-	{}
-};
-
-bool InitializeVAO(Geometry *geometry){
-
-	const GLuint VERTEX_INDEX = 0;
-	const GLuint TEXCOORD_INDEX = 1;
-
-	//Generate Vertex Buffer Objects
-	// create an array buffer object for storing our vertices
-	glGenBuffers(1, &geometry->vertexBuffer);
-	// create an array buffer object for storing our texture coordicates
-	glGenBuffers(1, &geometry->textureBuffer);
-
-	//Set up Vertex Array Object
-	// create a vertex array object encapsulating all our vertex attributes
-	glGenVertexArrays(1, &geometry->vertexArray);
-	glBindVertexArray(geometry->vertexArray);
-
-	// associate the position array with the vertex array object
-	glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
-	glVertexAttribPointer(
-		VERTEX_INDEX,		//Attribute index 
-		3, 					//# of components
-		GL_FLOAT, 			//Type of component
-		GL_FALSE, 			//Should be normalized?
-		sizeof(vec3),		//Stride - can use 0 if tightly packed
-		0);					//Offset to first element
-	glEnableVertexAttribArray(VERTEX_INDEX);
-
-	// associate the texture array with the texture coordinates array object
-	glBindBuffer(GL_ARRAY_BUFFER, geometry->textureBuffer);
-	glVertexAttribPointer(
-		TEXCOORD_INDEX,		//Attribute index
-		2, 					//# of components
-		GL_FLOAT, 			//Type of component
-		GL_FALSE, 			//Should be normalized?
-		sizeof(vec2), 		//Stride - can use 0 if tightly packed
-		0);					//Offset to first element
-	glEnableVertexAttribArray(TEXCOORD_INDEX);
-
-	// unbind our buffers, resetting to default state
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
-
-	return !CheckGLErrors();
-}
-
-// create buffers and fill with geometry data, returning true if successful
-bool LoadGeometry(Geometry *geometry, vec3 *vertices, vec2 *textures, int elementCount)
-{
-	geometry->elementCount = elementCount;
-
-	// create an array buffer object for storing our vertices
-	glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vec3)*geometry->elementCount, vertices, GL_STATIC_DRAW);
-
-	// create another one for storing our texture coordinates
-	glBindBuffer(GL_ARRAY_BUFFER, geometry->textureBuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vec2)*geometry->elementCount, textures, GL_STATIC_DRAW);
-
-	//Unbind buffer to reset to default state
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	SaveCachedProgram(program, key);
 
 	// check for OpenGL errors and return false if error occurred
-	return !CheckGLErrors();
-}
-
-// deallocate geometry-related objects
-void DestroyGeometry(Geometry *geometry)
-{
-	// unbind and destroy our vertex array object and associated buffers
-	glBindVertexArray(0);
-	glDeleteVertexArrays(1, &geometry->vertexArray);
-	glDeleteBuffers(1, &geometry->vertexBuffer);
-}
-
-// --------------------------------------------------------------------------
-// Rendering function that draws our scene to the frame buffer
-
-void RenderScene(MyTexture* tex, Geometry *geometry, GLuint program, Camera* camera, mat4 perspectiveMatrix, mat4 wMp, GLenum rendermode, int shadeflg, int nightflg, MyTexture* nighttex)
-{
-
-	// bind our shader program and the vertex array object containing our
-	// scene geometry, then tell OpenGL to draw our geometry
-	glUseProgram(program);
-
-	int vp [4];
-	glGetIntegerv(GL_VIEWPORT, vp);
-	int width = vp[2];
-	int height = vp[3];
-
-
-	//Bind uniforms
-	GLint uniformLocation;
-
-	mat4 modelViewProjection = perspectiveMatrix*camera->viewMatrix();
-	uniformLocation = glGetUniformLocation(program, "modelViewProjection");
-	glUniformMatrix4fv(uniformLocation, 1, false, glm::value_ptr(modelViewProjection));
-
-	uniformLocation = glGetUniformLocation(program, "modelMatrix");
-	glUniformMatrix4fv(uniformLocation, 1, false, glm::value_ptr(wMp));
-
-	uniformLocation = glGetUniformLocation(program, "shade_flg");
-	glUniform1i(uniformLocation, shadeflg);
-
-	uniformLocation = glGetUniformLocation(program, "night_flg");
-	glUniform1i(uniformLocation, nightflg);
-
-	glBindVertexArray(geometry->vertexArray);
-	glBindTexture(tex->target, tex->textureID);
-	glDrawArrays(rendermode, 0, geometry->elementCount);
-
-	glBindVertexArray(geometry->vertexArray);
-	glBindTexture(nighttex->target, nighttex->textureID);
-	glDrawArrays(rendermode, 0, geometry->elementCount);
-
-	// reset state to default (no shader or geometry bound)
-	glBindVertexArray(0);
-	glUseProgram(0);
-
-	// check for an report any OpenGL errors
-	CheckGLErrors();
+	return program;
 }
 
-void RenderEarth(MyTexture* tex, Geometry *geometry, GLuint program, Camera* camera, mat4 perspectiveMatrix, mat4 wMp, GLenum rendermode, int shadeflg, int nightflg, MyTexture* nighttex, MyTexture* spectex)
+// same with tessellation control and evaluation stages
+GLuint InitializeTessellationShaders(const string &vertexFile, const string &controlFile, const string &evaluationFile, const string &fragmentFile,
+									 const string &defines = "")
 {
+	string vertexSource = LoadSource(vertexFile, defines);
+	string controlSource = LoadSource(controlFile, defines);
+	string evaluationSource = LoadSource(evaluationFile, defines);
+	string fragmentSource = LoadSource(fragmentFile, defines);
+	if (vertexSource.empty() || controlSource.empty() || evaluationSource.empty() || fragmentSource.empty()) return false;
 
-	// bind our shader program and the vertex array object containing our
-	// scene geometry, then tell OpenGL to draw our geometry
-	glUseProgram(program);
-
-	int vp [4];
-	glGetIntegerv(GL_VIEWPORT, vp);
-	int width = vp[2];
-	int height = vp[3];
-
-
-	//Bind uniforms
-	GLint uniformLocation;
+	string key = ProgramCacheKey({vertexSource, controlSource, evaluationSource, fragmentSource});
+	if (GLuint cached = LoadCachedProgram(key)) return cached;
 
-	mat4 modelViewProjection = perspectiveMatrix*camera->viewMatrix();
-	uniformLocation = glGetUniformLocation(program, "modelViewProjection");
-	glUniformMatrix4fv(uniformLocation, 1, false, glm::value_ptr(modelViewProjection));
-
-	uniformLocation = glGetUniformLocation(program, "modelMatrix");
-	glUniformMatrix4fv(uniformLocation, 1, false, glm::value_ptr(wMp));
-
-	uniformLocation = glGetUniformLocation(program, "shade_flg");
-	glUniform1i(uniformLocation, shadeflg);
-
-	uniformLocation = glGetUniformLocation(program, "night_flg");
-	glUniform1i(uniformLocation, nightflg);
-
-	glBindVertexArray(geometry->vertexArray);
-	glBindTexture(tex->target, tex->textureID);
-	glDrawArrays(rendermode, 0, geometry->elementCount);
+	GLuint vertex = CompileShader(GL_VERTEX_SHADER, vertexSource);
+	GLuint control = CompileShader(GL_TESS_CONTROL_SHADER, controlSource);
+	GLuint evaluation = CompileShader(GL_TESS_EVALUATION_SHADER, evaluationSource);
+	GLuint fragment = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
 
-	glBindVertexArray(geometry->vertexArray);
-	glBindTexture(nighttex->target, nighttex->textureID);
-	glDrawArrays(rendermode, 0, geometry->elementCount);
+	GLuint program = LinkProgram(vertex, fragment, control, evaluation);
 
-	glBindVertexArray(geometry->vertexArray);
-	glBindTexture(spectex->target, spectex->textureID);
-	glDrawArrays(rendermode, 0, geometry->elementCount);
+	glDeleteShader(vertex);
+	glDeleteShader(control);
+	glDeleteShader(evaluation);
+	glDeleteShader(fragment);
 
-	// reset state to default (no shader or geometry bound)
-	glBindVertexArray(0);
-	glUseProgram(0);
+	SaveCachedProgram(program, key);
 
-	// check for an report any OpenGL errors
-	CheckGLErrors();
+	return program;
 }
 
 // --------------------------------------------------------------------------
@@ -380,10 +283,36 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 	else if(key == GLFW_KEY_R && action == GLFW_PRESS){
 		ROTATION_SCALER = 50.f;
 	}
+
+	else if(key == GLFW_KEY_I && action == GLFW_PRESS){
+		instanced_flg = 1 - instanced_flg;
+	}
+
+	else if(key == GLFW_KEY_P && action == GLFW_PRESS){
+		procedural_flg = 1 - procedural_flg;
+	}
+
+	else if(key == GLFW_KEY_T && action == GLFW_PRESS){
+		tessellated_flg = 1 - tessellated_flg;
+	}
+
+	else if(key == GLFW_KEY_C && action == GLFW_PRESS){
+		terrain_flg = 1 - terrain_flg;
+		// only the terrain holds up close to the surface
+		cam_min_r = terrain_flg == 1 ? SCALER_SUN*(1.f + TERRAIN_MIN_ALTITUDE) : SCALER_SUN + 0.1f;
+		if(cam.radius < cam_min_r) cam.radius = cam_min_r;
+	}
+
+	else if(key == GLFW_KEY_O && action == GLFW_PRESS){
+		occlusion_flg = 1 - occlusion_flg;
+	}
 }
 
 void  scroll_callback(GLFWwindow* window, double xoffset, double yoffset){
-	cam.radius -= yoffset * SCALER_CAM_RADIUS;
+	// close to the terrain every step shrinks with the altitude
+	float step = SCALER_CAM_RADIUS;
+	if(terrain_flg == 1) step *= std::min(1.f, (cam.radius - SCALER_SUN)/SCALER_SUN);
+	cam.radius -= yoffset * step;
 	if(cam.radius > cam_max_r) cam.radius = cam_max_r;
 	else if(cam.radius < cam_min_r) cam.radius = cam_min_r;
 	cam.pos.y = cam.radius * cos(cam_phi);
@@ -392,92 +321,37 @@ void  scroll_callback(GLFWwindow* window, double xoffset, double yoffset){
 }
 
 
-void planetMaker(vector<vec3>* sphere, vector<vec2>* texCoord, int n){
-	float step = PI_F/n;
-	float p = 0;
-	float t = step;
-	float ty = 1.f - 1.f/n;
-	float tx = 0;
-	for(int i = 0; i<n-2; i++){
-		p = 0;
-		tx = 0;
-		for(int j = 0; j<2*n; j++){
-			float t1 = t + step;
-			float p1 = p + step;
-			float tx1 = tx + 0.5f/n;
-			float ty1 = ty - 1.f/n;
-			sphere->push_back(vec3(sin(t)*cos(p), cos(t), sin(t)*sin(p)));
-			sphere->push_back(vec3(sin(t1)*cos(p), cos(t1), sin(t1)*sin(p)));
-			sphere->push_back(vec3(sin(t1)*cos(p1), cos(t1), sin(t1)*sin(p1)));
-			
-			sphere->push_back(vec3(sin(t)*cos(p), cos(t), sin(t)*sin(p)));
-			sphere->push_back(vec3(sin(t1)*cos(p1), cos(t1), sin(t1)*sin(p1)));
-			sphere->push_back(vec3(sin(t)*cos(p1), cos(t), sin(t)*sin(p1)));
-
-			texCoord->push_back(vec2(tx, ty));
-			texCoord->push_back(vec2(tx, ty1));
-			texCoord->push_back(vec2(tx1, ty1));
-
-			texCoord->push_back(vec2(tx, ty));
-			texCoord->push_back(vec2(tx1, ty1));
-			texCoord->push_back(vec2(tx1, ty));
-
-			p+=step;
-			tx+=0.5f/n;
-		}
-		t+=step;
-		ty-=1.f/n;
-	}
-	// North pole and south pole
-	p = 0;
-	tx = 0;
-	for(int j = 0; j<2*n; j++){
-		 	t = step; ty = 1.f - 1.f/n;
-			sphere->push_back(vec3(sin(t)*cos(p), cos(t), sin(t)*sin(p)));
-			sphere->push_back(vec3(sin(t)*cos(p+step), cos(t), sin(t)*sin(p+step)));
-			sphere->push_back(vec3(0.f, 1.f, 0.f));
-
-			texCoord->push_back(vec2(tx, ty));
-			texCoord->push_back(vec2(tx+0.5f/n, ty));
-			texCoord->push_back(vec2(tx, 1.f));
-
-			t = PI_F - step; ty = 1.f/n;
-			sphere->push_back(vec3(sin(t)*cos(p), cos(t), sin(t)*sin(p)));
-			sphere->push_back(vec3(sin(t)*cos(p+step), cos(t), sin(t)*sin(p+step)));
-			sphere->push_back(vec3(0.f, -1.f, 0.f));
-
-			texCoord->push_back(vec2(tx, ty));
-			texCoord->push_back(vec2(tx+0.5f/n, ty));
-			texCoord->push_back(vec2(tx, 0.f));
-
-			p+=step;
-			tx+=0.5f/n;
+//----------------------- Mesh loaders ---------------------------//
+// fill the buffers of a geometry created by the mesh registry
+
+bool LoadPlanetMesh(Geometry *geometry, int n){
+	// generators with a known size write the indices straight into the mapped
+	// element buffer, only the vertex attributes are staged for packing
+	int vertexCount, indexCount;
+	if(sphere_generator->size(n, &vertexCount, &indexCount)){
+		bool loaded = LoadGeometryMapped(geometry, vertexCount, indexCount, [n](vec3 *vertices, vec2 *textures, GLuint *indices){
+			sphere_generator->fill(vertices, textures, indices, n);
+		}, PACK_POSITIONS | PACK_TEXCOORDS);
+		cout << "Sphere mesh (" << sphere_generator->name() << ", n=" << n << "): " << vertexCount << " vertices, "
+			<< indexCount/3 << " triangles, written to mapped buffers, "
+			<< geometry->format.vertexSize() << " bytes per vertex" << endl;
+		return loaded;
 	}
+
+	MeshData Planet;
+	sphere_generator->generate(&Planet, n);
+	bool loaded = LoadGeometry(geometry, Planet.positions.data(), Planet.texCoords.data(), Planet.positions.size(),
+		Planet.indices.data(), Planet.indices.size(), PACK_POSITIONS | PACK_TEXCOORDS);
+	cout << "Sphere mesh (" << sphere_generator->name() << ", n=" << n << "): " << Planet.positions.size() << " vertices, "
+		<< Planet.indices.size()/3 << " triangles, ACMR " << ComputeACMR(Planet.indices) << ", "
+		<< geometry->format.vertexSize() << " bytes per vertex" << endl;
+	return loaded;
 }
 
-void generateRing(vector<vec3>* ring, vector<vec2>* texCoord){
-	float step = 2*PI_F/128.f;
-	float in_r = 67300.f/60300.f;
-	float out_r = 140300.f/60300.f;
-	for(float i = 0; i< 2*PI_F; i+=step){
-		vec3 p1 = vec3(cos(i),0,sin(i)) * in_r;
-		vec3 p2 = vec3(cos(i),0,sin(i)) * out_r;
-		vec3 p3 = vec3(cos(i+step),0,sin(i+step)) * in_r;
-		vec3 p4 = vec3(cos(i+step),0,sin(i+step)) * out_r;
-		ring->push_back(p1);
-		ring->push_back(p2);
-		ring->push_back(p3);
-		ring->push_back(p3);
-		ring->push_back(p2);
-		ring->push_back(p4);
-
-		texCoord->push_back(vec2(0.1,0));
-		texCoord->push_back(vec2(1,0));
-		texCoord->push_back(vec2(0.1,1));
-		texCoord->push_back(vec2(0.1,1));
-		texCoord->push_back(vec2(1,0));
-		texCoord->push_back(vec2(1,1));
-	}
+bool LoadRingMesh(Geometry *geometry){
+	return LoadGeometryMapped(geometry, RingVertexCount(), 0, [](vec3 *vertices, vec2 *textures, GLuint *){
+		FillRing(vertices, textures);
+	});
 }
 
 void debug3(char* s, vec3 v){
@@ -491,6 +365,13 @@ void debug3(char* s, vec3 v){
 
 int main(int argc, char *argv[])
 {
+	// the sphere generator can be picked with the first argument: uv (default), ico or cube
+	sphere_generator = FindMeshGenerator(argc > 1 ? argv[1] : "uv");
+	if (!sphere_generator) {
+		cout << "Unknown sphere generator " << argv[1] << ", use uv, ico or cube" << endl;
+		return -1;
+	}
+
 	// initialize the GLFW windowing system
 	if (!glfwInit()) {
 		cout << "ERROR: GLFW failed to initialize, TERMINATING" << endl;
@@ -505,7 +386,7 @@ int main(int argc, char *argv[])
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	int width = 1024, height = 1024;
-	window = glfwCreateWindow(width, height, "CPSC 453 OpenGL Boilerplate", 0, 0);
+	window = glfwCreateWindow(width, height, WINDOW_TITLE, 0, 0);
 	if (!window) {
 		cout << "Program failed to create GLFW window, TERMINATING" << endl;
 		glfwTerminate();
@@ -527,16 +408,46 @@ int main(int argc, char *argv[])
 	// query and print out information about our OpenGL environment
 	QueryGLVersion();
 
-	// call function to load and compile shader programs
-	GLuint program = InitializeShaders();
-	if (program == 0) {
-		cout << "Program could not initialize shaders, TERMINATING" << endl;
-		return -1;
+	// programs linked by an earlier run on this driver are loaded, not compiled
+	bool program_cache = InitializeProgramCache("programcache");
+	cout << "Program binary cache: " << (program_cache ? "on" : "off, compiling every program from source") << endl;
+
+	// call function to load and compile shader programs, each is reflected
+	// once so its uniforms are set without looking them up
+	// The programs drawing single bodies come in one variant per material
+	// feature combination, see material.h
+	ShaderProgram program[MATERIAL_VARIANTS], program_procedural[MATERIAL_VARIANTS];
+	ShaderProgram program_tessellated[MATERIAL_VARIANTS], program_impostor[MATERIAL_VARIANTS];
+	for(int variant = 0; variant < MATERIAL_VARIANTS; variant++){
+		string defines = MaterialDefines(variant);
+		if (!program[variant].reflect(InitializeShaders("shaders/vertex.glsl", "shaders/fragment.glsl", defines))) {
+			cout << "Program could not initialize shaders, TERMINATING" << endl;
+			return -1;
+		}
+		program_procedural[variant].reflect(InitializeShaders("shaders/procedural_vertex.glsl", "shaders/fragment.glsl", defines));
+		program_tessellated[variant].reflect(InitializeTessellationShaders("shaders/tess_vertex.glsl", "shaders/tess_control.glsl",
+																			"shaders/tess_evaluation.glsl", "shaders/fragment.glsl", defines));
+		program_impostor[variant].reflect(InitializeShaders("shaders/impostor_vertex.glsl", "shaders/impostor_fragment.glsl", defines));
 	}
-	GLuint program1 = InitializeShaders();
+	ShaderProgram program_sky, program_occlusion, program_instanced, program_indirect, program_ring_impostor;
+	program_sky.reflect(InitializeShaders("shaders/sky_vertex.glsl", "shaders/sky_fragment.glsl"));
+	program_occlusion.reflect(InitializeShaders("shaders/occlusion_vertex.glsl", "shaders/occlusion_fragment.glsl"));
+	program_instanced.reflect(InitializeShaders("shaders/instanced_vertex.glsl", "shaders/instanced_fragment.glsl"));
+	// contexts with multi-draw indirect draw the whole instanced scene in one
+	// call, unless the program fails to link on them
+	bool indirect_supported = InitializeIndirectDraw()
+		&& program_indirect.reflect(InitializeShaders("shaders/indirect_vertex.glsl", "shaders/instanced_fragment.glsl"))
+		&& InitializeIndirectProgram(program_indirect.handle());
+	cout << "Multi-draw indirect: " << (indirect_supported ? "on" : "off, using one instanced draw per level of detail") << endl;
+	glPatchParameteri(GL_PATCH_VERTICES, 3);
+	program_ring_impostor.reflect(InitializeShaders("shaders/ring_impostor_vertex.glsl", "shaders/ring_impostor_fragment.glsl"));
+	program_ring_impostor.use();
+	program_ring_impostor.setUniform(program_ring_impostor.uniformLocation("ringRadii"), vec2(RING_INNER_RADIUS, RING_OUTER_RADIUS));
+	glUseProgram(0);
 
 
 	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);		// filter the sky across cube map faces
 	glDepthFunc(GL_LEQUAL);
 
 	// three vertex positions and assocated colours of a triangle
@@ -544,94 +455,93 @@ int main(int argc, char *argv[])
 	//mat4(1.f) identity matrix
 	mat4 perspectiveMatrix = glm::perspective(PI_F*0.4f, float(width)/float(height), 0.0001f, 20.f);	//last 2 arg, nearst and farest
 
+	// the tessellated spheres size their edges in pixels
+	for(ShaderProgram& tessellated : program_tessellated){
+		tessellated.use();
+		tessellated.setUniform(tessellated.uniformLocation("pixelScale"), 0.5f*perspectiveMatrix[1][1]*height);
+		tessellated.setUniform(tessellated.uniformLocation("edgePixels"), LOD_EDGE_PIXELS);
+	}
+	glUseProgram(0);
+
 //----------------------- Generate Planets ---------------------------//
-	vector<vec3> Planet;		//vertices
-	vector<vec2> planetTex;	//texture
-	planetMaker(&Planet, &planetTex, 128);
-
-	Geometry geometry_sun;
-	Geometry geometry_earth;
-	Geometry geometry_star;
-	Geometry geometry_moon;
-	Geometry geometry_mars;
-	Geometry geometry_mercury;
-	Geometry geometry_venus;
-	Geometry geometry_jupiter;
-	Geometry geometry_saturn;
-	Geometry geometry_uranus;
-	Geometry geometry_neptune;
-	Geometry geometry_saturn_ring;
-
-
-	// call function to create and fill buffers with geometry data
-	if (!InitializeVAO(&geometry_sun))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_sun, Planet.data(), planetTex.data(),Planet.size()))
-		cout << "Failed to load geometry" << endl;
-
-	if (!InitializeVAO(&geometry_earth))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_earth, Planet.data(), planetTex.data(), Planet.size()))
-		cout << "Failed to load geometry" << endl;	
-
-	if (!InitializeVAO(&geometry_star))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_star, Planet.data(), planetTex.data(), Planet.size()))
-		cout << "Failed to load geometry" << endl;
-
-	if (!InitializeVAO(&geometry_moon))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_moon, Planet.data(), planetTex.data(), Planet.size()))
-		cout << "Failed to load geometry" << endl;
-
-	if (!InitializeVAO(&geometry_mars))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_mars, Planet.data(), planetTex.data(), Planet.size()))
-		cout << "Failed to load geometry" << endl;
-
-	if (!InitializeVAO(&geometry_mercury))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_mercury, Planet.data(), planetTex.data(), Planet.size()))
-		cout << "Failed to load geometry" << endl;
-
-	if (!InitializeVAO(&geometry_venus))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_venus, Planet.data(), planetTex.data(), Planet.size()))
-		cout << "Failed to load geometry" << endl;
-
-	if (!InitializeVAO(&geometry_jupiter))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_jupiter, Planet.data(), planetTex.data(), Planet.size()))
-		cout << "Failed to load geometry" << endl;
-
-	if (!InitializeVAO(&geometry_saturn))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_saturn, Planet.data(), planetTex.data(), Planet.size()))
-		cout << "Failed to load geometry" << endl;
-
-	if (!InitializeVAO(&geometry_uranus))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_uranus, Planet.data(), planetTex.data(), Planet.size()))
-		cout << "Failed to load geometry" << endl;
-
-	if (!InitializeVAO(&geometry_neptune))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_neptune, Planet.data(), planetTex.data(), Planet.size()))
-		cout << "Failed to load geometry" << endl;
-
-
-	vector<vec3> ring;
-	vector<vec2> ringtex;
-	generateRing(&ring, &ringtex);
-	if (!InitializeVAO(&geometry_saturn_ring))
-		cout << "Program failed to intialize geometry!" << endl;
-	if(!LoadGeometry(&geometry_saturn_ring, ring.data(), ringtex.data(), ringtex.size()))
-		cout << "Failed to load geometry" << endl;
+	// every sphere shares one upload per level of detail, the registry hands
+	// out handles to them, meshes are generated on the first run and mapped
+	// from the cache files afterwards
+	MeshRegistry meshes;
+	meshes.setCacheDirectory("meshcache");
+	MeshHandle planet_lods[LOD_LEVELS];
+	for(int level = 0; level < LOD_LEVELS; level++){
+		int n = LodSegments(level);
+		string name = string("planet_") + sphere_generator->name() + "_" + to_string(n);
+		planet_lods[level] = meshes.acquire(name, [n](Geometry *geometry){ return LoadPlanetMesh(geometry, n); });
+	}
+	MeshHandle geometry_saturn_ring = meshes.acquire("saturn_ring", LoadRingMesh);
+
+	cout << "Meshes: " << meshes.liveCount() << " uploaded for " << LOD_LEVELS << " planet levels and the ring, "
+		<< meshes.cacheHitCount() << " from the cache" << endl;
 
+	// the spherical bodies are drawn with one instanced draw per level of detail
+	InstanceBatch planets[LOD_LEVELS];
+	for(int level = 0; level < LOD_LEVELS; level++){
+		if (!InitializeInstanceBatch(&planets[level], planet_lods[level], BODY_COUNT))
+			cout << "Program failed to intialize instance batch!" << endl;
+	}
+	IndirectBatch planets_indirect;
+	if (indirect_supported && !InitializeIndirectBatch(&planets_indirect, planet_lods, LOD_LEVELS, BODY_COUNT)){
+		cout << "Program failed to intialize indirect batch!" << endl;
+		indirect_supported = false;
+	}
+	int body_lod[BODY_COUNT] = {0};
+
+	// the procedural spheres have no buffers, every body gets its own so its
+	// number of rings can follow its size on screen
+	Geometry procedural_spheres[BODY_COUNT];
+	for(int body = 0; body < BODY_COUNT; body++){
+		if (!InitializeProceduralSphere(&procedural_spheres[body], LOD_MAX_SEGMENTS))
+			cout << "Program failed to intialize procedural sphere!" << endl;
+	}
 
+	// the tessellated spheres refine one coarse procedural grid on the GPU,
+	// they need no level of detail of their own
+	Geometry tessellated_sphere;
+	if (!InitializeProceduralSphere(&tessellated_sphere, TESS_BASE_SEGMENTS))
+		cout << "Program failed to intialize tessellated sphere!" << endl;
+
+	// close-ups of the body the camera orbits use chunked terrain, generated
+	// on worker threads
+	Terrain terrain;
+	if (!InitializeTerrain(&terrain))
+		cout << "Program failed to intialize terrain!" << endl;
+
+	// distant bodies and the ring are ray-cast on a quad
+	Geometry impostor;
+	if (!InitializeImpostor(&impostor))
+		cout << "Program failed to intialize impostor!" << endl;
+	bool body_impostor[BODY_COUNT] = {false};
+
+	// the star background is one triangle covering the screen
+	Geometry sky_triangle;
+	if (!InitializeFullScreenTriangle(&sky_triangle))
+		cout << "Program failed to intialize sky triangle!" << endl;
+
+	// everything written every frame goes through one streaming buffer: the
+	// camera and the model matrices in uniform blocks that every program
+	// reads, the instances and the indirect draws
+	StreamBuffer stream;
+	if (!InitializeStreamBuffer(&stream))
+		cout << "Program failed to intialize streaming buffer!" << endl;
+	UniformBlocks blocks;
+	if (!InitializeUniformBlocks(&blocks, &stream, OBJECT_COUNT))
+		cout << "Program failed to intialize uniform blocks!" << endl;
+
+	RenderQueue queue;
+
+	// bodies found hidden by last frame's occlusion queries are skipped
+	OcclusionQueries occlusion;
+	if (!InitializeOcclusionQueries(&occlusion, OBJECT_COUNT))
+		cout << "Program failed to intialize occlusion queries!" << endl;
 
 	mat4 wMs, wMe, wMmoon, wMmars, wMmercury, wMjupiter, wMsaturn, wMuranus, wMvenus, wMneptune;
-	mat4 wMstar = mat4(SCALER_STAR * vec4(1,0,0,0), SCALER_STAR * vec4(0,1,0,0), SCALER_STAR * vec4(0,0,1,0), vec4(0,0,0,1));
 
 //----------------------- Generate Planets ---------------------------//
 
@@ -650,49 +560,58 @@ int main(int argc, char *argv[])
 
 	MyTexture texture_sun, texture_earth, texture_star, texture_moon, texture_earthnight;
 	MyTexture texture_mars, texture_venus, texture_mercury, texture_saturn, texture_jupiter, texture_uranus, texture_neptune, texture_saturn_ring, texture_earth_spec_map;
-	InitializeTexture(&texture_sun, "2k_sun.jpg", GL_TEXTURE_2D);
-	InitializeTexture(&texture_earth, "2k_earth_daymap.jpg", GL_TEXTURE_2D);
-	InitializeTexture(&texture_star, "8k_stars_milky_way.jpg", GL_TEXTURE_2D);
-	InitializeTexture(&texture_moon, "2k_moon.jpg", GL_TEXTURE_2D);
-	InitializeTexture(&texture_earthnight, "2k_earth_nightmap.jpg", GL_TEXTURE_2D);
-	//InitializeTexture(&texture_earthnight, "spec.jpg", GL_TEXTURE_2D);
-	InitializeTexture(&texture_mars, "2k_mars.jpg", GL_TEXTURE_2D);
-	InitializeTexture(&texture_mercury, "2k_mercury.jpg", GL_TEXTURE_2D);
-	InitializeTexture(&texture_neptune, "2k_neptune.jpg", GL_TEXTURE_2D);
-	InitializeTexture(&texture_jupiter, "2k_jupiter.jpg", GL_TEXTURE_2D);
-	InitializeTexture(&texture_saturn, "2k_saturn.jpg", GL_TEXTURE_2D);
-	InitializeTexture(&texture_uranus, "2k_uranus.jpg", GL_TEXTURE_2D);
-	InitializeTexture(&texture_venus, "2k_venus_atmosphere.jpg", GL_TEXTURE_2D);
+	InitializeTexture(&texture_sun, "2k_sun.jpg", GL_TEXTURE_2D, GL_REPEAT);
+	InitializeTexture(&texture_earth, "2k_earth_daymap.jpg", GL_TEXTURE_2D, GL_REPEAT);
+	InitializeCubeMap(&texture_star, "8k_stars_milky_way.jpg", SKY_FACE_SIZE);
+	InitializeTexture(&texture_moon, "2k_moon.jpg", GL_TEXTURE_2D, GL_REPEAT);
+	InitializeTexture(&texture_earthnight, "2k_earth_nightmap.jpg", GL_TEXTURE_2D, GL_REPEAT);
+	//InitializeTexture(&texture_earthnight, "spec.jpg", GL_TEXTURE_2D, GL_REPEAT);
+	InitializeTexture(&texture_mars, "2k_mars.jpg", GL_TEXTURE_2D, GL_REPEAT);
+	InitializeTexture(&texture_mercury, "2k_mercury.jpg", GL_TEXTURE_2D, GL_REPEAT);
+	InitializeTexture(&texture_neptune, "2k_neptune.jpg", GL_TEXTURE_2D, GL_REPEAT);
+	InitializeTexture(&texture_jupiter, "2k_jupiter.jpg", GL_TEXTURE_2D, GL_REPEAT);
+	InitializeTexture(&texture_saturn, "2k_saturn.jpg", GL_TEXTURE_2D, GL_REPEAT);
+	InitializeTexture(&texture_uranus, "2k_uranus.jpg", GL_TEXTURE_2D, GL_REPEAT);
+	InitializeTexture(&texture_venus, "2k_venus_atmosphere.jpg", GL_TEXTURE_2D, GL_REPEAT);
 	InitializeTexture(&texture_saturn_ring, "2k_saturn_ring_alpha.png", GL_TEXTURE_2D);
-	InitializeTexture(&texture_earth_spec_map, "spec.jpg", GL_TEXTURE_2D);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture_sun.textureID);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, texture_earth.textureID);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, texture_star.textureID);
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, texture_moon.textureID);
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_2D, texture_earthnight.textureID);
-	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_2D, texture_mars.textureID);
-	glActiveTexture(GL_TEXTURE6);
-	glBindTexture(GL_TEXTURE_2D, texture_venus.textureID);
-	glActiveTexture(GL_TEXTURE7);
-	glBindTexture(GL_TEXTURE_2D, texture_mercury.textureID);
-	glActiveTexture(GL_TEXTURE8);
-	glBindTexture(GL_TEXTURE_2D, texture_jupiter.textureID);
-	glActiveTexture(GL_TEXTURE9);
-	glBindTexture(GL_TEXTURE_2D, texture_saturn.textureID);
-	glActiveTexture(GL_TEXTURE10);
-	glBindTexture(GL_TEXTURE_2D, texture_uranus.textureID);
-	glActiveTexture(GL_TEXTURE11);
-	glBindTexture(GL_TEXTURE_2D, texture_neptune.textureID);
-	glActiveTexture(GL_TEXTURE12);
-	glBindTexture(GL_TEXTURE_2D, texture_saturn_ring.textureID);
-	glActiveTexture(GL_TEXTURE13);
-	glBindTexture(GL_TEXTURE_2D, texture_earth_spec_map.textureID);
+	InitializeTexture(&texture_earth_spec_map, "spec.jpg", GL_TEXTURE_2D, GL_REPEAT);
+
+	// the same images as layers of one texture array for the instanced path
+	MyTexture texture_layers;
+	bool layers_loaded = InitializeTextureArray(&texture_layers, LAYER_FILES, LAYER_COUNT, 2048, 1024);
+	if (!layers_loaded)
+		cout << "Texture array failed to load, drawing bodies one by one" << endl;
+	glActiveTexture(GL_TEXTURE14);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture_layers.textureID);
+	program_instanced.use();
+	program_instanced.set(UNIFORM_LAYERS, 14);
+	program_indirect.use();
+	program_indirect.set(UNIFORM_LAYERS, 14);
+	glUseProgram(0);
+
+	// materials of the bodies, in the order of the instance array, their
+	// textures are bound to the material units as each body is drawn
+	Material materials[BODY_COUNT] = {
+		{&texture_sun, 0, 0, 0},
+		{&texture_earth, &texture_earthnight, &texture_earth_spec_map, 1},
+		{&texture_moon, 0, 0, 1},
+		{&texture_mars, 0, 0, 1},
+		{&texture_mercury, 0, 0, 1},
+		{&texture_venus, 0, 0, 1},
+		{&texture_jupiter, 0, 0, 1},
+		{&texture_saturn, 0, 0, 1},
+		{&texture_uranus, 0, 0, 1},
+		{&texture_neptune, 0, 0, 1}
+	};
+	Material material_star = {&texture_star, 0, 0, 0};
+	Material material_saturn_ring = {&texture_saturn_ring, 0, 0, 0};
+	for(int variant = 0; variant < MATERIAL_VARIANTS; variant++){
+		ShaderProgram* material_programs[] = {&program[variant], &program_procedural[variant], &program_tessellated[variant], &program_impostor[variant]};
+		for(ShaderProgram* materialProgram : material_programs)
+			SetMaterialSamplers(materialProgram);
+	}
+	SetMaterialSamplers(&program_sky);
+	SetMaterialSamplers(&program_ring_impostor);
 
 
 	//------------------------- Bind texture ------------------------//
@@ -952,7 +871,6 @@ int main(int argc, char *argv[])
 			cam_scaler = SCALER_NEPTUNE/SCALER_SUN;
 			cam_transition = wMneptune[3];
 		}
-		wMstar = mat4(SCALER_STAR * vec4(1,0,0,0), SCALER_STAR * vec4(0,1,0,0), SCALER_STAR * vec4(0,0,1,0), vec4(cam_transition,1));
 
 		//Rotation
 		double xpos, ypos;
@@ -985,82 +903,196 @@ int main(int argc, char *argv[])
 		// clear screen to a dark grey colour
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// Render sun
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "image"), 0); 
-		RenderScene(&texture_sun, &geometry_sun, program, &cam, perspectiveMatrix, wMs, GL_TRIANGLES ,0,0, &texture_earthnight);
-
-		// Render earth
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "pecularmap"), 13);
-		glUniform1i(glGetUniformLocation(program, "image"), 1);
-		glUniform1i(glGetUniformLocation(program, "nightmap"), 4);
-		glUniform3f(glGetUniformLocation(program, "camPosition"), cam.pos.x, cam.pos.y, cam.pos.z);
-		RenderEarth(&texture_earth, &geometry_earth, program, &cam, perspectiveMatrix, wMe, GL_TRIANGLES,1,1, &texture_earthnight, &texture_earth_spec_map);
-
-		// Render star background
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "image"), 2);
-		RenderScene(&texture_star, &geometry_star, program, &cam, perspectiveMatrix, wMstar, GL_TRIANGLES,0,0, &texture_earthnight);
-
-		// Render moon
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "image"), 3);
-		RenderScene(&texture_moon, &geometry_moon, program, &cam, perspectiveMatrix, wMmoon, GL_TRIANGLES,1,0, &texture_earthnight);
-
-		// Render Mars
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "image"), 5);
-		RenderScene(&texture_mars, &geometry_mars, program, &cam, perspectiveMatrix, wMmars, GL_TRIANGLES,1,0, &texture_mars);
-
-		// Render Mercury
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "image"), 7);
-		RenderScene(&texture_mercury, &geometry_mercury, program, &cam, perspectiveMatrix, wMmercury, GL_TRIANGLES,1,0, &texture_mercury);
-
-		// Render Venus
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "image"), 6);
-		RenderScene(&texture_venus, &geometry_venus, program, &cam, perspectiveMatrix, wMvenus, GL_TRIANGLES,1,0, &texture_venus);
-
-		// Render Jupiter
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "image"), 8);
-		RenderScene(&texture_jupiter, &geometry_jupiter, program, &cam, perspectiveMatrix, wMjupiter, GL_TRIANGLES,1,0, &texture_jupiter);
-
-		// Render Saturn
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "image"), 9);
-		RenderScene(&texture_saturn, &geometry_saturn, program, &cam, perspectiveMatrix, wMsaturn, GL_TRIANGLES,1,0, &texture_saturn);
-
-		// Render Saturn Rings
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "image"), 12);
-		RenderScene(&texture_saturn_ring, &geometry_saturn_ring, program, &cam, perspectiveMatrix, wMsaturn, GL_TRIANGLES,0,0, &texture_saturn_ring); 
-
-
-		// Render Uranus
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "image"), 10);
-		RenderScene(&texture_uranus, &geometry_uranus, program, &cam, perspectiveMatrix, wMuranus, GL_TRIANGLES,1,0, &texture_uranus);
-
-		// Render Neptune
-		glUseProgram(program);
-		glUniform1i(glGetUniformLocation(program, "image"), 11);
-		RenderScene(&texture_neptune, &geometry_neptune, program, &cam, perspectiveMatrix, wMneptune, GL_TRIANGLES,1,0, &texture_neptune);
+		ResetFrameStats();
+
+		// Pick every body's level of detail from its size on screen
+		InstanceData instances[BODY_COUNT] = {
+			{wMs, {LAYER_SUN, NO_LAYER, NO_LAYER, 0}},
+			{wMe, {LAYER_EARTH, LAYER_EARTH_NIGHT, LAYER_EARTH_SPEC, 1}},
+			{wMmoon, {LAYER_MOON, NO_LAYER, NO_LAYER, 1}},
+			{wMmars, {LAYER_MARS, NO_LAYER, NO_LAYER, 1}},
+			{wMmercury, {LAYER_MERCURY, NO_LAYER, NO_LAYER, 1}},
+			{wMvenus, {LAYER_VENUS, NO_LAYER, NO_LAYER, 1}},
+			{wMjupiter, {LAYER_JUPITER, NO_LAYER, NO_LAYER, 1}},
+			{wMsaturn, {LAYER_SATURN, NO_LAYER, NO_LAYER, 1}},
+			{wMuranus, {LAYER_URANUS, NO_LAYER, NO_LAYER, 1}},
+			{wMneptune, {LAYER_NEPTUNE, NO_LAYER, NO_LAYER, 1}}
+		};
+		for(int body = 0; body < BODY_COUNT; body++){
+			const mat4& model = instances[body].modelMatrix;
+			float screenRadius = ProjectedRadius(cam, perspectiveMatrix, vec3(model[3]), length(vec3(model[0])), height);
+			body_lod[body] = SelectLod(screenRadius, body_lod[body]);
+			SetProceduralSegments(&procedural_spheres[body], SegmentsForRadius(screenRadius));
+			body_impostor[body] = screenRadius < IMPOSTOR_MAX_PIXELS;
+		}
+
+		// Skip the bodies and the ring outside the view
+		Frustum frustum = cam.frustum(perspectiveMatrix);
+		bool body_visible[BODY_COUNT];
+		for(int body = 0; body < BODY_COUNT; body++){
+			body_visible[body] = frustum.intersects(WorldBounds(instances[body].modelMatrix, 1.f));
+			if(!body_visible[body]) frameStats.culled++;
+		}
+		bool ring_visible = frustum.intersects(WorldBounds(wMsaturn, RING_OUTER_RADIUS));
+		if(!ring_visible) frameStats.culled++;
+
+		// Skip the bodies in view that were hidden behind others last frame,
+		// they are still queried below so they show up again
+		bool body_in_view[BODY_COUNT];
+		ReadOcclusionResults(&occlusion);
+		for(int body = 0; body < BODY_COUNT; body++){
+			body_in_view[body] = body_visible[body] && occlusion_flg == 1;
+			if(body_in_view[body] && Occluded(&occlusion, body)){
+				body_visible[body] = false;
+				frameStats.occluded++;
+			}
+		}
+
+		// Write the camera and every object's model matrix for this frame, once
+		// the GPU is done with the stream region this frame reuses
+		BeginStreamFrame(&stream);
+		UpdateFrameBlock(&blocks, perspectiveMatrix*cam.viewMatrix(), cam.pos, float(glfwGetTime()));
+		mat4 objects[OBJECT_COUNT];
+		for(int body = 0; body < BODY_COUNT; body++)
+			objects[body] = instances[body].modelMatrix;
+		UpdateObjectBlocks(&blocks, objects, OBJECT_COUNT);
+
+		// the body the camera orbits is drawn from its terrain once the root
+		// chunks are ready
+		int terrain_body = -1;
+		if(terrain_flg == 1){
+			int body = MODE_BODIES[planet_mode];
+			if(body_visible[body] && !body_impostor[body] && UpdateTerrain(&terrain, instances[body].modelMatrix, cam.pos))
+				terrain_body = body;
+		}
+
+		// Everything drawn this frame goes through the render queue, which
+		// sorts the opaque draws front to back and draws the sky last
+		ClearRenderQueue(&queue);
+
+		// distance from the camera to the surface of an object's bounding sphere
+		auto depth = [&](int object){
+			return std::max(length(vec3(objects[object][3]) - cam.pos) - length(vec3(objects[object][0])), 0.f);
+		};
+
+		bool instanced = instanced_flg == 1 && layers_loaded && procedural_flg == 0 && tessellated_flg == 0;
+		auto batched = [&](int body){
+			return body_visible[body] && !body_impostor[body] && body != terrain_body;
+		};
+		if(instanced && indirect_supported){
+			// Queue the spherical bodies as one multi-draw, each with the mesh
+			// of its level of detail, the impostors are drawn on their own below
+			InstanceData draws[BODY_COUNT];
+			int drawMeshes[BODY_COUNT];
+			int count = 0;
+			float nearest = FLT_MAX;
+			for(int body = 0; body < BODY_COUNT; body++){
+				if(batched(body)){
+					drawMeshes[count] = body_lod[body];
+					draws[count++] = instances[body];
+					nearest = std::min(nearest, depth(body));
+				}
+			}
+			UpdateIndirectDraws(&planets_indirect, &stream, drawMeshes, draws, count);
+			SubmitIndirect(&queue, &program_indirect, &planets_indirect, GL_TRIANGLES, nearest);
+		}
+		else if(instanced){
+			// Queue the spherical bodies as one instanced draw per level of
+			// detail, the impostors are drawn on their own below
+			for(int level = 0; level < LOD_LEVELS; level++){
+				InstanceData levelInstances[BODY_COUNT];
+				int count = 0;
+				float nearest = FLT_MAX;
+				for(int body = 0; body < BODY_COUNT; body++){
+					if(batched(body) && body_lod[body] == level){
+						levelInstances[count++] = instances[body];
+						nearest = std::min(nearest, depth(body));
+					}
+				}
+				UpdateInstances(&planets[level], &stream, levelInstances, count);
+				SubmitInstances(&queue, &program_instanced, &planets[level], GL_TRIANGLES, nearest);
+			}
+		}
+
+		// Every visible body not in an instance batch or terrain is drawn on its own:
+		// distant ones as impostors, the others from the mesh of their level of
+		// detail or procedurally or tessellated
+		auto drawn_alone = [&](int body){
+			return body_visible[body] && (!instanced || body_impostor[body]) && body != terrain_body;
+		};
+		auto body_program = [&](int body) -> ShaderProgram* {
+			int variant = MaterialVariant(&materials[body]);
+			if(body_impostor[body]) return &program_impostor[variant];
+			if(tessellated_flg == 1) return &program_tessellated[variant];
+			return procedural_flg == 1 ? &program_procedural[variant] : &program[variant];
+		};
+		auto sphere = [&](int body) -> Geometry* {
+			if(body_impostor[body]) return &impostor;
+			if(tessellated_flg == 1) return &tessellated_sphere;
+			return procedural_flg == 1 ? &procedural_spheres[body] : planet_lods[body_lod[body]].get();
+		};
+		auto sphere_mode = [&](int body) -> GLenum {
+			return tessellated_flg == 1 && !body_impostor[body] ? GL_PATCHES : GL_TRIANGLES;
+		};
+		// Queue the bodies with one draw each
+		for(int body = 0; body < BODY_COUNT; body++){
+			if(drawn_alone(body))
+				SubmitGeometry(&queue, body_program(body), &materials[body], sphere(body), body, sphere_mode(body), depth(body));
+		}
+
+		// Queue the terrain of the body the camera orbits
+		if(terrain_body >= 0)
+			SubmitTerrain(&queue, &program[MaterialVariant(&materials[terrain_body])], &materials[terrain_body], &terrain, terrain_body, depth(terrain_body));
+
+
+		// Queue Saturn Rings, ray-cast on their plane along with a distant Saturn
+		ShaderProgram* ring_program = body_impostor[BODY_SATURN] ? &program_ring_impostor : &program[MaterialVariant(&material_saturn_ring)];
+		if(ring_visible)
+			SubmitGeometry(&queue, ring_program, &material_saturn_ring, body_impostor[BODY_SATURN] ? &impostor : geometry_saturn_ring.get(),
+						   BODY_SATURN, GL_TRIANGLES, depth(BODY_SATURN));
+
+		// Queue star background, drawn last on the far plane where nothing covers it
+		SubmitGeometry(&queue, &program_sky, &material_star, &sky_triangle, -1, GL_TRIANGLES, 0.f, RENDER_PASS_SKY);
+
+		FlushStreamBuffer(&stream);
+		ExecuteRenderQueue(&queue, &blocks);
+		IssueOcclusionQueries(&occlusion, &program_occlusion, &blocks, objects, body_in_view, cam.pos);
+		EndStreamFrame(&stream);
 
 		glfwSwapBuffers(window);
+		ReportFrameStats(window, WINDOW_TITLE);
 
 		glfwPollEvents();
 	}
 
 	// clean up allocated resources before exit
-	DestroyGeometry(&geometry_sun);
-	DestroyGeometry(&geometry_earth);
-	DestroyGeometry(&geometry_star);
-	DestroyGeometry(&geometry_moon);
+	// release the mesh handles while the context is still alive
+	for(int level = 0; level < LOD_LEVELS; level++){
+		DestroyInstanceBatch(&planets[level]);
+		planet_lods[level].reset();
+	}
+	DestroyIndirectBatch(&planets_indirect);
+	for(int body = 0; body < BODY_COUNT; body++)
+		DestroyGeometry(&procedural_spheres[body]);
+	DestroyGeometry(&tessellated_sphere);
+	DestroyTerrain(&terrain);
+	DestroyGeometry(&impostor);
+	DestroyGeometry(&sky_triangle);
+	DestroyOcclusionQueries(&occlusion);
+	DestroyStreamBuffer(&stream);
+	geometry_saturn_ring.reset();
 	glUseProgram(0);
-	glDeleteProgram(program);
+	for(int variant = 0; variant < MATERIAL_VARIANTS; variant++){
+		program[variant].destroy();
+		program_procedural[variant].destroy();
+		program_tessellated[variant].destroy();
+		program_impostor[variant].destroy();
+	}
+	program_sky.destroy();
+	program_occlusion.destroy();
+	program_instanced.destroy();
+	program_indirect.destroy();
+	program_ring_impostor.destroy();
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
@@ -1114,8 +1146,9 @@ bool CheckGLErrors()
 // --------------------------------------------------------------------------
 // OpenGL shader support functions
 
-// reads a text file with the given name into a string
-string LoadSource(const string &filename)
+// reads a text file with the given name into a string, the defines are
+// inserted after its #version line
+string LoadSource(const string &filename, const string &defines)
 {
 	string source;
 
@@ -1131,6 +1164,16 @@ string LoadSource(const string &filename)
 			<< filename << endl;
 	}
 
+	// the #version line has to come first, the #line after the defines keeps
+	// the line numbers of compile errors those of the file
+	size_t version = source.find("#version");
+	if (!defines.empty() && version != string::npos) {
+		size_t end = source.find('\n', version);
+		if (end == string::npos) end = source.size() - 1;
+		int nextLine = int(count(source.begin(), source.begin() + end, '\n')) + 2;
+		source.insert(end + 1, defines + "#line " + to_string(nextLine) + "\n");
+	}
+
 	return source;
 }
 
@@ -1163,7 +1206,7 @@ GLuint CompileShader(GLenum shaderType, const string &source)
 }
 
 // creates and returns a program object linked from vertex and fragment shaders
-GLuint LinkProgram(GLuint vertexShader, GLuint fragmentShader)
+GLuint LinkProgram(GLuint vertexShader, GLuint fragmentShader, GLuint controlShader, GLuint evaluationShader)
 {
 	// allocate program object name
 	GLuint programObject = glCreateProgram();
@@ -1171,6 +1214,10 @@ GLuint LinkProgram(GLuint vertexShader, GLuint fragmentShader)
 	// attach provided shader objects to this program
 	if (vertexShader)   glAttachShader(programObject, vertexShader);
 	if (fragmentShader) glAttachShader(programObject, fragmentShader);
+	if (controlShader) glAttachShader(programObject, controlShader);
+	if (evaluationShader) glAttachShader(programObject, evaluationShader);
+
+	RetainProgramBinary(programObject);
 
 	// try linking the program with given attachments
 	glLinkProgram(programObject);
@@ -0,0 +1,35 @@
+#include "framestats.h"
+#include <sstream>
+
+using namespace std;
+
+#define REPORT_INTERVAL 0.5		// Seconds between window title updates
+
+FrameStats frameStats;
+
+FrameStats::FrameStats() : drawCalls(0), triangles(0), uniformUploads(0), stateChanges(0), culled(0), occlusionQueries(0), occluded(0)
+	{}
+
+void ResetFrameStats(){
+	frameStats = FrameStats();
+}
+
+void ReportFrameStats(GLFWwindow *window, const char *title){
+	static double lastReport = 0.0;
+	static int frames = 0;
+
+	frames++;
+	double now = glfwGetTime();
+	if(now - lastReport < REPORT_INTERVAL) return;
+
+	ostringstream text;
+	text << title << " | " << int(frames/(now - lastReport) + 0.5) << " fps | "
+		<< frameStats.drawCalls << " draws | " << frameStats.triangles << " triangles | "
+		<< frameStats.uniformUploads << " uniforms | " << frameStats.stateChanges << " state changes | "
+		<< frameStats.culled << " culled | " << frameStats.occlusionQueries << " queries | "
+		<< frameStats.occluded << " occluded";
+	glfwSetWindowTitle(window, text.str().c_str());
+
+	lastReport = now;
+	frames = 0;
+}
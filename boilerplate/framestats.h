@@ -0,0 +1,30 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+// --------------------------------------------------------------------------
+// Per frame rendering statistics
+//	Draw functions add to frameStats, the main loop resets it every frame and
+//	shows it in the window title.
+
+struct FrameStats
+{
+	int drawCalls;
+	long triangles;
+	int uniformUploads;		//Uniform values that changed and were uploaded
+	int stateChanges;		//Program, material, vertex array and object binds of the render queue
+	int culled;				//Bodies and rings outside the view frustum, not drawn
+	int occlusionQueries;	//Occlusion queries issued
+	int occluded;			//Bodies hidden behind others by last frame's queries, not drawn
+
+	FrameStats();
+};
+
+extern FrameStats frameStats;
+
+//Clears the counters, call at the start of every frame
+void ResetFrameStats();
+
+//Shows the counters of the frame that just finished in the window title,
+//at most a few times per second
+void ReportFrameStats(GLFWwindow *window, const char *title);
@@ -0,0 +1,296 @@
+#include "geometry.h"
+#include "framestats.h"
+#include <cmath>
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+bool CheckGLErrors();
+
+Geometry::Geometry() : vertexBuffer(0), indexBuffer(0), vertexArray(0), elementCount(0), indexCount(0), segments(0), format()
+	{}
+
+int VertexFormat::vertexSize() const{
+	const VertexAttribute* attributes[3] = {&position, &texCoord, &normal};
+	int size = 0;
+	for(int a = 0; a<3; a++){
+		int componentSize = attributes[a]->type == GL_SHORT ? sizeof(GLshort) : sizeof(GLfloat);
+		size += attributes[a]->components * componentSize;
+	}
+	return size;
+}
+
+bool InitializeVAO(Geometry *geometry){
+
+	//Generate Vertex Buffer Objects
+	// create an array buffer object for storing our interleaved vertices
+	glGenBuffers(1, &geometry->vertexBuffer);
+	// create an element buffer object for storing our triangle indices
+	glGenBuffers(1, &geometry->indexBuffer);
+
+	//Set up Vertex Array Object
+	// create a vertex array object encapsulating all our vertex attributes
+	glGenVertexArrays(1, &geometry->vertexArray);
+	glBindVertexArray(geometry->vertexArray);
+
+	// the element buffer binding is part of the vertex array object state
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->indexBuffer);
+
+	// unbind our buffers, resetting to default state
+	glBindVertexArray(0);
+
+	return !CheckGLErrors();
+}
+
+void BindVertexFormat(const Geometry *geometry){
+	const VertexAttribute* attributes[3] = {&geometry->format.position, &geometry->format.texCoord, &geometry->format.normal};
+
+	glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
+	for(GLuint index = 0; index<3; index++){
+		const VertexAttribute& attribute = *attributes[index];
+		if(attribute.components == 0){
+			glDisableVertexAttribArray(index);
+			continue;
+		}
+		glVertexAttribPointer(
+			index,							//Attribute index
+			attribute.components, 			//# of components
+			attribute.type, 				//Type of component
+			attribute.type == GL_SHORT, 	//Should be normalized? snorm shorts map to [-1, 1]
+			attribute.stride,				//Stride
+			(void*)attribute.offset);		//Offset to first element
+		glEnableVertexAttribArray(index);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// --------------------------------------------------------------------------
+// Vertex packing
+
+static GLshort PackSnorm(float value){
+	return GLshort(round(clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+static bool FitsSnorm(const float* values, int count){
+	for(int k = 0; k<count; k++)
+		if(values[k] < -1.f || values[k] > 1.f) return false;
+	return true;
+}
+
+// Octahedral encoding: the unit vector is projected onto the octahedron
+// |x|+|y|+|z| = 1 and the lower half is folded over the upper one, which
+// keeps the precision even over the sphere with only two components
+static vec2 OctahedralEncode(vec3 n){
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 p(n.x, n.y);
+	if(n.z < 0.f){
+		vec2 signs(p.x >= 0.f ? 1.f : -1.f, p.y >= 0.f ? 1.f : -1.f);
+		p = (vec2(1.f) - abs(vec2(p.y, p.x))) * signs;
+	}
+	return p;
+}
+
+// Adds an attribute to the end of an interleaved vertex
+static void AppendAttribute(VertexAttribute* attribute, int components, bool packed, GLsizei* size){
+	attribute->components = components;
+	attribute->type = packed ? GL_SHORT : GL_FLOAT;
+	attribute->offset = *size;
+	*size += components * (packed ? sizeof(GLshort) : sizeof(GLfloat));
+}
+
+// Writes a value into an interleaved vertex, as floats or snorm shorts
+static void StoreAttribute(char* vertex, const VertexAttribute& attribute, const float* value){
+	if(attribute.type == GL_SHORT){
+		GLshort* out = (GLshort*)(vertex + attribute.offset);
+		for(int c = 0; c<attribute.components; c++) out[c] = PackSnorm(c < 3 ? value[c] : 0.f);
+	}
+	else{
+		float* out = (float*)(vertex + attribute.offset);
+		for(int c = 0; c<attribute.components; c++) out[c] = value[c];
+	}
+}
+
+// Picks the interleaved layout of a mesh for the packing flags, returning the
+// stride. An attribute is kept as floats if its values do not fit the snorm range
+static GLsizei ChooseVertexFormat(VertexFormat* format, const vec3 *vertices, const vec2 *textures, int elementCount, int packing)
+{
+	bool packPositions = (packing & PACK_POSITIONS) && FitsSnorm(&vertices[0].x, 3*elementCount);
+	bool packTexCoords = (packing & PACK_TEXCOORDS) && FitsSnorm(&textures[0].x, 2*elementCount);
+
+	// a packed position gets a fourth component so the next attribute stays
+	// aligned to 4 bytes
+	*format = VertexFormat();
+	GLsizei stride = 0;
+	AppendAttribute(&format->position, packPositions ? 4 : 3, packPositions, &stride);
+	AppendAttribute(&format->texCoord, 2, packTexCoords, &stride);
+	if(packing & PACK_NORMALS)
+		AppendAttribute(&format->normal, 2, true, &stride);
+	format->position.stride = format->texCoord.stride = format->normal.stride = stride;
+	return stride;
+}
+
+// Writes the vertices interleaved in the given format
+static void InterleaveVertices(char *data, const VertexFormat& format, const vec3 *vertices, const vec2 *textures, int elementCount)
+{
+	GLsizei stride = format.position.stride;
+	for(int v = 0; v<elementCount; v++){
+		char* vertex = data + size_t(v)*stride;
+		StoreAttribute(vertex, format.position, &vertices[v].x);
+		StoreAttribute(vertex, format.texCoord, &textures[v].x);
+		if(format.normal.components > 0){
+			vec2 normal = OctahedralEncode(normalize(vertices[v]));
+			StoreAttribute(vertex, format.normal, &normal.x);
+		}
+	}
+}
+
+// create buffers and fill with geometry data, returning true if successful
+bool LoadGeometry(Geometry *geometry, vec3 *vertices, vec2 *textures, int elementCount, int packing)
+{
+	geometry->elementCount = elementCount;
+	geometry->indexCount = 0;
+
+	GLsizei stride = ChooseVertexFormat(&geometry->format, vertices, textures, elementCount, packing);
+	vector<char> data(size_t(stride)*elementCount);
+	InterleaveVertices(data.data(), geometry->format, vertices, textures, elementCount);
+
+	// create an array buffer object for storing our vertices
+	glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, data.size(), data.data(), GL_STATIC_DRAW);
+
+	//Unbind buffer to reset to default state
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindVertexArray(geometry->vertexArray);
+	BindVertexFormat(geometry);
+	glBindVertexArray(0);
+
+	// check for OpenGL errors and return false if error occurred
+	return !CheckGLErrors();
+}
+
+bool LoadGeometry(Geometry *geometry, vec3 *vertices, vec2 *textures, int elementCount,
+					GLuint *indices, int indexCount, int packing)
+{
+	if(!LoadGeometry(geometry, vertices, textures, elementCount, packing))
+		return false;
+
+	geometry->indexCount = indexCount;
+
+	// the element buffer has to be filled through the vertex array object,
+	// binding it with no vertex array bound would not be recorded anywhere
+	glBindVertexArray(geometry->vertexArray);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*geometry->indexCount, indices, GL_STATIC_DRAW);
+	glBindVertexArray(0);
+
+	return !CheckGLErrors();
+}
+
+// allocates the buffer bound to target and maps all of it for writing
+static void* MapNewBuffer(GLenum target, GLsizeiptr size)
+{
+	glBufferData(target, size, 0, GL_STATIC_DRAW);
+	if(size == 0) return 0;
+	return glMapBufferRange(target, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+}
+
+bool LoadGeometryMapped(Geometry *geometry, int elementCount, int indexCount, GeometryWriter write, int packing)
+{
+	geometry->elementCount = elementCount;
+	geometry->indexCount = indexCount;
+
+	// the attributes are staged so they can be packed and interleaved in the
+	// same layout as LoadGeometry's, the indices need no conversion
+	vector<vec3> vertices(elementCount);
+	vector<vec2> textures(elementCount);
+
+	// the element buffer is bound through the vertex array object, see LoadGeometry
+	glBindVertexArray(geometry->vertexArray);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->indexBuffer);
+	GLuint *indices = (GLuint*)MapNewBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*indexCount);
+	bool mapped = indices || indexCount == 0;
+	if(mapped) write(vertices.data(), textures.data(), indices);
+
+	char *data = 0;
+	if(mapped){
+		GLsizei stride = ChooseVertexFormat(&geometry->format, vertices.data(), textures.data(), elementCount, packing);
+		glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
+		data = (char*)MapNewBuffer(GL_ARRAY_BUFFER, GLsizeiptr(stride)*elementCount);
+		mapped = data != 0;
+		if(mapped) InterleaveVertices(data, geometry->format, vertices.data(), textures.data(), elementCount);
+	}
+
+	// unmapping fails if the contents were lost while mapped (e.g. a mode
+	// switch), the caller then has to load the geometry again
+	bool intact = true;
+	if(indices) intact = glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) && intact;
+	glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
+	if(data) intact = glUnmapBuffer(GL_ARRAY_BUFFER) && intact;
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	BindVertexFormat(geometry);
+	glBindVertexArray(0);
+
+	return mapped && intact && !CheckGLErrors();
+}
+
+bool InitializeProceduralSphere(Geometry *geometry, int n)
+{
+	// a core profile context needs a vertex array object bound to draw, even
+	// one without any enabled attributes
+	glGenVertexArrays(1, &geometry->vertexArray);
+	SetProceduralSegments(geometry, n);
+
+	return !CheckGLErrors();
+}
+
+void SetProceduralSegments(Geometry *geometry, int n)
+{
+	// every quad of the 2n by n grid is drawn as 6 vertices
+	geometry->segments = n;
+	geometry->elementCount = 12*n*n;
+	geometry->indexCount = 0;
+}
+
+bool InitializeImpostor(Geometry *geometry)
+{
+	glGenVertexArrays(1, &geometry->vertexArray);
+	geometry->elementCount = 6;
+	geometry->indexCount = 0;
+
+	return !CheckGLErrors();
+}
+
+bool InitializeFullScreenTriangle(Geometry *geometry)
+{
+	glGenVertexArrays(1, &geometry->vertexArray);
+	geometry->elementCount = 3;
+	geometry->indexCount = 0;
+
+	return !CheckGLErrors();
+}
+
+void DrawGeometry(const Geometry *geometry, GLenum rendermode)
+{
+	if(geometry->indexCount > 0)
+		glDrawElements(rendermode, geometry->indexCount, GL_UNSIGNED_INT, 0);
+	else
+		glDrawArrays(rendermode, 0, geometry->elementCount);
+
+	frameStats.drawCalls++;
+	// a triangle patch counts once, what it is tessellated into is only known on the GPU
+	frameStats.triangles += (geometry->indexCount > 0 ? geometry->indexCount : geometry->elementCount)/3;
+}
+
+// deallocate geometry-related objects
+void DestroyGeometry(Geometry *geometry)
+{
+	// unbind and destroy our vertex array object and associated buffers
+	glBindVertexArray(0);
+	glDeleteVertexArrays(1, &geometry->vertexArray);
+	glDeleteBuffers(1, &geometry->vertexBuffer);
+	glDeleteBuffers(1, &geometry->indexBuffer);
+}
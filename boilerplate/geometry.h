@@ -0,0 +1,116 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <functional>
+
+// --------------------------------------------------------------------------
+// Functions to set up OpenGL buffers for storing geometry data
+
+//Vertex attributes can be stored as 16 bit snorm components instead of
+//floats, or these together to pick which
+#define PACK_NONE 0
+#define PACK_POSITIONS 1		//Positions must lie in [-1, 1], e.g. the unit spheres
+#define PACK_TEXCOORDS 2		//Texture coordinates must lie in [-1, 1]
+#define PACK_NORMALS 4			//Adds an octahedral encoded normal, see LoadGeometry
+
+//Where and how one attribute is stored in the vertex buffer
+struct VertexAttribute
+{
+	GLint     components;		//0 if the geometry does not have the attribute
+	GLenum    type;				//GL_FLOAT, or GL_SHORT read as normalized
+	GLsizei   stride;
+	GLintptr  offset;
+};
+
+//Layout of the vertex buffer of a geometry
+//	Attribute 0 is the position, 1 the texture coordinate and 2 the normal
+struct VertexFormat
+{
+	VertexAttribute position;
+	VertexAttribute texCoord;
+	VertexAttribute normal;
+
+	//Bytes per vertex, summed over the attributes
+	int vertexSize() const;
+};
+
+struct Geometry
+{
+	// OpenGL names for array buffer objects, vertex array object
+	GLuint  vertexBuffer;		//Every vertex attribute, laid out as described by format
+	GLuint  indexBuffer;		//Element buffer, only filled for indexed meshes
+	GLuint  vertexArray;
+	GLsizei elementCount;		//Number of vertices in the buffers
+	GLsizei indexCount;			//Number of indices, 0 if drawn with glDrawArrays
+	GLint   segments;			//Rings of a procedural sphere, 0 if drawn from the buffers
+	VertexFormat format;
+
+	// initialize object names to zero (OpenGL reserved value)
+	Geometry();
+};
+
+//Creates the buffers and the vertex array object for a geometry, the vertex
+//attributes are set up once the geometry is loaded and its format is known
+bool InitializeVAO(Geometry *geometry);
+
+//Points the attributes of the bound vertex array object at the vertex buffer
+//of a geometry, as described by its format
+void BindVertexFormat(const Geometry *geometry);
+
+// create buffers and fill with geometry data, returning true if successful
+//	The attributes are interleaved in one buffer. An attribute requested in
+//	packing whose values do not fit the snorm range is kept as floats.
+//	PACK_NORMALS stores the normalized position as the normal, which is only
+//	meaningful for spheres centred on the origin.
+bool LoadGeometry(Geometry *geometry, glm::vec3 *vertices, glm::vec2 *textures, int elementCount, int packing = PACK_NONE);
+
+//Same as above but also fills the element buffer, the geometry is then
+//drawn with glDrawElements
+// ARGS:
+//	vertices, textures - per vertex attributes, elementCount entries each
+//	indices - triangle list referencing the vertices, indexCount entries
+//	packing - PACK_ flags of the attributes to store as 16 bit snorm
+bool LoadGeometry(Geometry *geometry, glm::vec3 *vertices, glm::vec2 *textures, int elementCount,
+					GLuint *indices, int indexCount, int packing = PACK_NONE);
+
+//Writes the attributes and indices of a mesh, see LoadGeometryMapped
+typedef std::function<void(glm::vec3 *vertices, glm::vec2 *textures, GLuint *indices)> GeometryWriter;
+
+//Same as above but the mesh is generated in place instead of being copied
+//from the caller's arrays: the indices are written straight into the mapped
+//element buffer, the attributes into staging arrays that are then packed
+//and interleaved into the mapped vertex buffer, in the same layout as
+//LoadGeometry's.
+// ARGS:
+//	elementCount - number of vertices write fills
+//	indexCount - number of indices write fills, 0 for glDrawArrays (indices is null)
+//	write - called once with the staging arrays and the mapped element buffer
+//	packing - PACK_ flags of the attributes to store as 16 bit snorm
+bool LoadGeometryMapped(Geometry *geometry, int elementCount, int indexCount, GeometryWriter write, int packing = PACK_NONE);
+
+//Sets up a sphere drawn without any vertex buffers, the vertex shader
+//(shaders/procedural_vertex.glsl) builds planetMaker's sphere from gl_VertexID.
+//Only an empty vertex array object is created.
+// ARGS:
+//	n - number of rings, see SetProceduralSegments
+bool InitializeProceduralSphere(Geometry *geometry, int n);
+
+//Changes the number of rings of a procedural sphere, nothing is uploaded so
+//this can be done every frame. The shader's "segments" uniform must be set
+//from geometry->segments before drawing.
+void SetProceduralSegments(Geometry *geometry, int n);
+
+//Sets up the quad an impostor is drawn on, built from gl_VertexID like the
+//procedural sphere: an empty vertex array object and 6 vertices
+bool InitializeImpostor(Geometry *geometry);
+
+//Sets up a triangle covering the whole screen, built from gl_VertexID: an
+//empty vertex array object and 3 vertices
+bool InitializeFullScreenTriangle(Geometry *geometry);
+
+//Issues the draw call for a geometry, the vertex array object must be bound
+void DrawGeometry(const Geometry *geometry, GLenum rendermode);
+
+// deallocate geometry-related objects
+void DestroyGeometry(Geometry *geometry);
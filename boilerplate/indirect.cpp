@@ -0,0 +1,182 @@
+#include "indirect.h"
+#include "framestats.h"
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+bool CheckGLErrors();
+
+// the loader only covers GL 4.0, the rest is looked up at runtime
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#define GL_SHADER_STORAGE_BLOCK 0x92E6
+#endif
+typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+typedef GLuint (APIENTRYP GetProgramResourceIndexProc)(GLuint program, GLenum programInterface, const GLchar *name);
+typedef void (APIENTRYP ShaderStorageBlockBindingProc)(GLuint program, GLuint storageBlockIndex, GLuint storageBlockBinding);
+static MultiDrawElementsIndirectProc multiDrawElementsIndirect = 0;
+static GetProgramResourceIndexProc getProgramResourceIndex = 0;
+static ShaderStorageBlockBindingProc shaderStorageBlockBinding = 0;
+
+//True if the context lists the extension
+static bool HasExtension(const char *name){
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for(GLint i = 0; i < count; i++){
+		if(strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), name) == 0) return true;
+	}
+	return false;
+}
+
+bool InitializeIndirectDraw(){
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	bool core43 = major > 4 || (major == 4 && minor >= 3);
+
+	bool supported = (core43 || HasExtension("GL_ARB_multi_draw_indirect"))
+		&& (core43 || HasExtension("GL_ARB_shader_storage_buffer_object"))
+		&& (core43 || HasExtension("GL_ARB_program_interface_query"))
+		&& HasExtension("GL_ARB_shader_draw_parameters");
+	if(supported){
+		multiDrawElementsIndirect = (MultiDrawElementsIndirectProc)glfwGetProcAddress("glMultiDrawElementsIndirect");
+		getProgramResourceIndex = (GetProgramResourceIndexProc)glfwGetProcAddress("glGetProgramResourceIndex");
+		shaderStorageBlockBinding = (ShaderStorageBlockBindingProc)glfwGetProcAddress("glShaderStorageBlockBinding");
+		supported = multiDrawElementsIndirect && getProgramResourceIndex && shaderStorageBlockBinding;
+	}
+	return supported;
+}
+
+bool InitializeIndirectProgram(GLuint program){
+	if(!shaderStorageBlockBinding || program == 0) return false;
+
+	// the shader is #version 410, which cannot give the block a binding itself
+	GLuint index = getProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, "DrawBlock");
+	if(index == GL_INVALID_INDEX) return false;
+	shaderStorageBlockBinding(program, index, INDIRECT_DRAW_BINDING);
+	return !CheckGLErrors();
+}
+
+//True if both attributes are stored the same way, compared member by member
+//since the struct has padding
+static bool SameAttribute(const VertexAttribute& a, const VertexAttribute& b){
+	return a.components == b.components && a.type == b.type && a.stride == b.stride && a.offset == b.offset;
+}
+
+//True if every vertex is one block of vertexSize bytes, which is what lets
+//a mesh be copied whole and placed with a base vertex
+static bool Interleaved(const VertexFormat& format, int vertexSize){
+	const VertexAttribute* attributes[3] = {&format.position, &format.texCoord, &format.normal};
+	for(int a = 0; a < 3; a++){
+		if(attributes[a]->components == 0) continue;
+		if(attributes[a]->stride != vertexSize || attributes[a]->offset >= vertexSize) return false;
+	}
+	return true;
+}
+
+IndirectBatch::IndirectBatch() : streamBuffer(0), commandOffset(0), drawOffset(0), drawAlignment(1), drawCount(0), capacity(0), triangles(0)
+	{}
+
+bool InitializeIndirectBatch(IndirectBatch *batch, const MeshHandle *meshes, int meshCount, int capacity){
+	if(!multiDrawElementsIndirect || meshCount == 0) return false;
+
+	// sizes of the shared buffers, the meshes must be drawable as one
+	GLsizeiptr vertexBytes = 0, indexBytes = 0;
+	int vertexSize = meshes[0]->format.vertexSize();
+	for(int m = 0; m < meshCount; m++){
+		const Geometry *mesh = meshes[m].get();
+		const VertexFormat& format = mesh->format;
+		const VertexFormat& first = meshes[0]->format;
+		if(mesh->indexCount == 0 || !Interleaved(format, vertexSize) || !SameAttribute(format.position, first.position)
+			|| !SameAttribute(format.texCoord, first.texCoord) || !SameAttribute(format.normal, first.normal)){
+			cout << "Meshes of an indirect batch must be indexed, interleaved and share a vertex format" << endl;
+			return false;
+		}
+		vertexBytes += GLsizeiptr(mesh->elementCount)*vertexSize;
+		indexBytes += GLsizeiptr(mesh->indexCount)*sizeof(GLuint);
+	}
+
+	if(!InitializeVAO(&batch->geometry)) return false;
+	batch->geometry.format = meshes[0]->format;
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, batch->geometry.vertexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, vertexBytes, 0, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, batch->geometry.indexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, indexBytes, 0, GL_STATIC_DRAW);
+
+	// copy every mesh behind the previous one, on the GPU
+	batch->meshes.clear();
+	GLint vertexOffset = 0;
+	GLuint indexOffset = 0;
+	for(int m = 0; m < meshCount; m++){
+		const Geometry *mesh = meshes[m].get();
+		glBindBuffer(GL_COPY_READ_BUFFER, mesh->vertexBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, batch->geometry.vertexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, GLintptr(vertexOffset)*vertexSize,
+							GLsizeiptr(mesh->elementCount)*vertexSize);
+		glBindBuffer(GL_COPY_READ_BUFFER, mesh->indexBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, batch->geometry.indexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, GLintptr(indexOffset)*sizeof(GLuint),
+							GLsizeiptr(mesh->indexCount)*sizeof(GLuint));
+
+		IndirectMesh placed = {indexOffset, vertexOffset, GLuint(mesh->indexCount)};
+		batch->meshes.push_back(placed);
+		vertexOffset += mesh->elementCount;
+		indexOffset += mesh->indexCount;
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	batch->geometry.elementCount = vertexOffset;
+	batch->geometry.indexCount = indexOffset;
+
+	glBindVertexArray(batch->geometry.vertexArray);
+	BindVertexFormat(&batch->geometry);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	batch->capacity = capacity;
+	batch->drawCount = 0;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &batch->drawAlignment);
+
+	return !CheckGLErrors();
+}
+
+void UpdateIndirectDraws(IndirectBatch *batch, StreamBuffer *stream, const int *meshIndices, const InstanceData *draws, int count){
+	if(count > batch->capacity) count = batch->capacity;
+	batch->drawCount = count;
+	batch->triangles = 0;
+
+	vector<DrawElementsIndirectCommand> commands(count);
+	for(int i = 0; i < count; i++){
+		const IndirectMesh& mesh = batch->meshes[meshIndices[i]];
+		DrawElementsIndirectCommand command = {mesh.indexCount, 1, mesh.firstIndex, mesh.baseVertex, 0};
+		commands[i] = command;
+		batch->triangles += mesh.indexCount/3;
+	}
+
+	// both move through the stream, the commands only need word alignment
+	batch->streamBuffer = stream->buffer;
+	batch->commandOffset = StreamWrite(stream, commands.data(), sizeof(DrawElementsIndirectCommand)*count, sizeof(GLuint));
+	batch->drawOffset = StreamWrite(stream, draws, sizeof(InstanceData)*count, batch->drawAlignment);
+	if(batch->commandOffset < 0 || batch->drawOffset < 0) batch->drawCount = 0;
+}
+
+void DrawIndirect(const IndirectBatch *batch, GLenum rendermode){
+	if(batch->drawCount == 0) return;
+
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, INDIRECT_DRAW_BINDING, batch->streamBuffer,
+					  batch->drawOffset, sizeof(InstanceData)*batch->drawCount);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch->streamBuffer);
+	multiDrawElementsIndirect(rendermode, GL_UNSIGNED_INT, (const void*)batch->commandOffset, batch->drawCount, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	frameStats.drawCalls++;
+	frameStats.triangles += batch->triangles;
+}
+
+void DestroyIndirectBatch(IndirectBatch *batch){
+	DestroyGeometry(&batch->geometry);
+}
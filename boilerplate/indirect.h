@@ -0,0 +1,80 @@
+#pragma once
+#include "geometry.h"
+#include "instancing.h"
+#include "meshregistry.h"
+#include "streambuffer.h"
+#include <vector>
+
+// --------------------------------------------------------------------------
+// Multi-draw indirect rendering of the whole scene
+//	Every mesh of the batch is copied into one vertex and one index buffer,
+//	so a draw of any of them is a command in a buffer. The commands of a frame
+//	are written to the streaming buffer and submitted with a single
+//	glMultiDrawElementsIndirect, and each draw reads its model matrix and
+//	material from a shader storage range of the stream indexed by
+//	gl_DrawIDARB. The driver work per frame does not grow with the number of
+//	bodies.
+//	This needs GL 4.3 or the multi-draw indirect, shader storage buffer and
+//	program interface query extensions, plus ARB_shader_draw_parameters for
+//	the draw id. Contexts without them, e.g. the 4.1 of OS X, or whose driver
+//	fails to link the program keep using instancing.h.
+
+#define INDIRECT_DRAW_BINDING 2		//Shader storage binding of the per draw data
+
+//Where a mesh sits in the shared buffers
+struct IndirectMesh
+{
+	GLuint firstIndex;
+	GLint  baseVertex;
+	GLuint indexCount;
+};
+
+//Command read by glMultiDrawElementsIndirect, laid out as the GL expects
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint  baseVertex;
+	GLuint baseInstance;
+};
+
+struct IndirectBatch
+{
+	Geometry geometry;				//Every mesh, vertexArray reads from the shared buffers
+	std::vector<IndirectMesh> meshes;
+	GLuint   streamBuffer;			//Buffer holding this frame's commands and draws
+	GLintptr commandOffset;
+	GLintptr drawOffset;			//InstanceData of every draw, std430 layout
+	GLint    drawAlignment;			//GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+	GLsizei drawCount;
+	GLsizei capacity;
+	long triangles;					//Triangles of the current commands
+
+	IndirectBatch();
+};
+
+//Checks the context for multi-draw indirect, shader storage buffers and the
+//draw id, and loads the functions not covered by the loader. Call once after
+//the context is made current
+bool InitializeIndirectDraw();
+
+//Points the DrawBlock storage block of a linked indirect program at
+//INDIRECT_DRAW_BINDING, returns false if the program has no such block
+bool InitializeIndirectProgram(GLuint program);
+
+//Copies the meshes into the shared buffers, they must all be indexed and have
+//the same interleaved vertex format
+//	capacity - most draws per frame
+bool InitializeIndirectBatch(IndirectBatch *batch, const MeshHandle *meshes, int meshCount, int capacity);
+
+//Replaces the draws of the batch, draw i uses meshes[meshIndices[i]] with
+//draws[i]. At most capacity are kept
+void UpdateIndirectDraws(IndirectBatch *batch, StreamBuffer *stream, const int *meshIndices, const InstanceData *draws, int count);
+
+//Submits every draw of the batch with one call, the program must be in use
+//and the vertex array of the batch bound, see renderqueue.h
+void DrawIndirect(const IndirectBatch *batch, GLenum rendermode);
+
+// deallocate batch-related objects
+void DestroyIndirectBatch(IndirectBatch *batch);
@@ -0,0 +1,87 @@
+#include "instancing.h"
+#include "framestats.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <cstddef>
+
+using namespace glm;
+
+bool CheckGLErrors();
+
+InstanceBatch::InstanceBatch() : vertexArray(0), instanceCount(0), capacity(0)
+	{}
+
+bool InitializeInstanceBatch(InstanceBatch *batch, MeshHandle mesh, int capacity){
+
+	batch->mesh = mesh;
+	batch->capacity = capacity;
+	batch->instanceCount = 0;
+
+	glGenVertexArrays(1, &batch->vertexArray);
+	glBindVertexArray(batch->vertexArray);
+
+	// per vertex attributes come from the shared mesh buffer, in its format
+	BindVertexFormat(mesh.get());
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+
+	// per instance attributes advance once per instance, a mat4 takes one
+	// attribute location per column
+	for(int column = 0; column < 4; column++){
+		glEnableVertexAttribArray(INSTANCE_MODEL_INDEX + column);
+		glVertexAttribDivisor(INSTANCE_MODEL_INDEX + column, 1);
+	}
+	glEnableVertexAttribArray(INSTANCE_MATERIAL_INDEX);
+	glVertexAttribDivisor(INSTANCE_MATERIAL_INDEX, 1);
+
+	// unbind our buffers, resetting to default state
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	return !CheckGLErrors();
+}
+
+void UpdateInstances(InstanceBatch *batch, StreamBuffer *stream, const InstanceData *instances, int count){
+	if(count > batch->capacity) count = batch->capacity;
+
+	// the instances move through the stream, point the attributes at this
+	// frame's copy
+	GLintptr offset = StreamWrite(stream, instances, sizeof(InstanceData)*count, sizeof(vec4));
+	batch->instanceCount = offset < 0 ? 0 : count;
+	if(batch->instanceCount == 0) return;
+
+	glBindVertexArray(batch->vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, stream->buffer);
+	for(int column = 0; column < 4; column++){
+		glVertexAttribPointer(
+			INSTANCE_MODEL_INDEX + column,	//Attribute index
+			4, 						//# of components
+			GL_FLOAT, 				//Type of component
+			GL_FALSE, 				//Should be normalized?
+			sizeof(InstanceData),	//Stride
+			(void*)(offset + offsetof(InstanceData, modelMatrix) + column*sizeof(vec4)));	//Offset to first element
+	}
+	glVertexAttribIPointer(INSTANCE_MATERIAL_INDEX, 4, GL_INT, sizeof(InstanceData),
+		(void*)(offset + offsetof(InstanceData, material)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void DrawInstances(const InstanceBatch *batch, GLenum rendermode)
+{
+	if(batch->instanceCount == 0) return;
+
+	if(batch->mesh->indexCount > 0)
+		glDrawElementsInstanced(rendermode, batch->mesh->indexCount, GL_UNSIGNED_INT, 0, batch->instanceCount);
+	else
+		glDrawArraysInstanced(rendermode, 0, batch->mesh->elementCount, batch->instanceCount);
+
+	GLsizei vertices = batch->mesh->indexCount > 0 ? batch->mesh->indexCount : batch->mesh->elementCount;
+	frameStats.drawCalls++;
+	frameStats.triangles += long(vertices/3) * batch->instanceCount;
+}
+
+void DestroyInstanceBatch(InstanceBatch *batch){
+	glBindVertexArray(0);
+	glDeleteVertexArrays(1, &batch->vertexArray);
+	batch->mesh.reset();
+}
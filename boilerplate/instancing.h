@@ -0,0 +1,53 @@
+#pragma once
+#include "geometry.h"
+#include "meshregistry.h"
+#include "streambuffer.h"
+
+// --------------------------------------------------------------------------
+// Instanced rendering of many bodies sharing one mesh
+//	Each body's model matrix and material are written to the streaming buffer
+//	every frame and the whole batch is drawn with a single
+//	glDrawElementsInstanced.
+
+#define INSTANCE_MODEL_INDEX 3		//mat4, uses attribute locations 3 to 6
+#define INSTANCE_MATERIAL_INDEX 7
+
+//Material of an instance, layers index the texture array of the batch
+#define NO_LAYER -1
+struct InstanceMaterial
+{
+	GLint dayLayer;
+	GLint nightLayer;		//NO_LAYER if the body has no night side texture
+	GLint specularLayer;	//NO_LAYER if the body has no specular map
+	GLint shade;			//1 if lit by the sun, 0 if emissive
+};
+
+struct InstanceData
+{
+	glm::mat4 modelMatrix;
+	InstanceMaterial material;
+};
+
+struct InstanceBatch
+{
+	MeshHandle mesh;		//Shared mesh drawn for every instance
+	GLuint vertexArray;		//Mesh attributes plus the per instance attributes
+	GLsizei instanceCount;
+	GLsizei capacity;
+
+	InstanceBatch();
+};
+
+//Creates a vertex array object reading the buffers of the mesh, the instance
+//attributes are pointed at the stream by UpdateInstances
+bool InitializeInstanceBatch(InstanceBatch *batch, MeshHandle mesh, int capacity);
+
+//Replaces the instances of the batch, at most capacity are kept
+void UpdateInstances(InstanceBatch *batch, StreamBuffer *stream, const InstanceData *instances, int count);
+
+//Draws every instance of the batch with one draw call, the program must be
+//in use and the vertex array of the batch bound, see renderqueue.h
+void DrawInstances(const InstanceBatch *batch, GLenum rendermode);
+
+// deallocate batch-related objects, the mesh handle is released
+void DestroyInstanceBatch(InstanceBatch *batch);
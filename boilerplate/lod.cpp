@@ -0,0 +1,41 @@
+#include "lod.h"
+
+using namespace glm;
+
+#define PI_F 3.14159265359f
+
+int LodSegments(int level){
+	return LOD_MAX_SEGMENTS >> level;
+}
+
+float ProjectedRadius(const Camera& camera, const mat4& perspectiveMatrix, vec3 centre, float radius, int viewportHeight){
+	float distance = length(centre - camera.pos);
+	if(distance <= radius) return 1e9f;
+
+	// perspectiveMatrix[1][1] is 1/tan(fovy/2), the view distance to the sphere
+	// is approximated by the distance to its centre
+	return radius * perspectiveMatrix[1][1] / distance * 0.5f * viewportHeight;
+}
+
+// coarsest level whose triangle edges stay under LOD_EDGE_PIXELS, a UV sphere
+// with n rings has edges of about PI*r/n on its equator
+static int LodForRadius(float screenRadius){
+	for(int level = LOD_LEVELS - 1; level > 0; level--){
+		if(PI_F * screenRadius / LodSegments(level) <= LOD_EDGE_PIXELS)
+			return level;
+	}
+	return 0;
+}
+
+int SelectLod(float screenRadius, int currentLevel){
+	int desired = LodForRadius(screenRadius);
+	if(desired <= currentLevel) return desired;
+
+	int relaxed = LodForRadius(screenRadius * (1.f + LOD_HYSTERESIS));
+	return relaxed > currentLevel ? relaxed : currentLevel;
+}
+
+int SegmentsForRadius(float screenRadius){
+	float n = ceil(PI_F * screenRadius / LOD_EDGE_PIXELS);
+	return int(clamp(n, float(LodSegments(LOD_LEVELS - 1)), float(LOD_MAX_SEGMENTS)));
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "Camera.h"
+
+// --------------------------------------------------------------------------
+// Level of detail selection for the planet spheres
+//	Level 0 is the finest tessellation, every following level halves the
+//	number of rings. The level of a body is picked from its radius on screen.
+
+#define LOD_LEVELS 5
+#define LOD_MAX_SEGMENTS 128		//Number of rings of level 0
+#define LOD_EDGE_PIXELS 6.f			//Longest acceptable triangle edge on screen
+#define LOD_HYSTERESIS 0.25f		//Fraction the radius must shrink past a switch point before coarsening
+#define IMPOSTOR_MAX_PIXELS 64.f	//Bodies with a smaller radius on screen are ray-cast on a quad instead
+#define TESS_BASE_SEGMENTS 4		//Rings of the coarse sphere refined by the tessellation shaders
+
+//Number of rings (planetMaker's n) of a level
+int LodSegments(int level);
+
+//Radius in pixels of a sphere on screen, very large if the camera is inside it
+// ARGS:
+//	centre, radius - sphere in world space
+//	viewportHeight - height of the viewport in pixels
+float ProjectedRadius(const Camera& camera, const glm::mat4& perspectiveMatrix, glm::vec3 centre, float radius, int viewportHeight);
+
+//Picks the level for a sphere with the given radius on screen
+//	Switching to a finer level happens immediately, switching to a coarser one
+//	only once the radius is LOD_HYSTERESIS below the switch point, so a body
+//	sitting on a boundary does not pop back and forth every frame
+// ARGS:
+//	screenRadius - from ProjectedRadius
+//	currentLevel - level used for the body last frame
+int SelectLod(float screenRadius, int currentLevel);
+
+//Rings for a procedural sphere, which can use any number of rings for free:
+//the fewest that keep the equator edges under LOD_EDGE_PIXELS, clamped to the
+//range of the mesh levels
+int SegmentsForRadius(float screenRadius);
@@ -0,0 +1,38 @@
+#include "material.h"
+
+// texture bound to each material unit by BindMaterial, 0 before the first bind
+static GLuint boundTextures[3] = {0, 0, 0};
+
+static void BindUnit(GLuint unit, const MyTexture *texture){
+	if(!texture || boundTextures[unit] == texture->textureID) return;
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(texture->target, texture->textureID);
+	boundTextures[unit] = texture->textureID;
+}
+
+void SetMaterialSamplers(ShaderProgram *program){
+	program->use();
+	program->set(UNIFORM_IMAGE, MATERIAL_DAY_UNIT);
+	program->set(UNIFORM_NIGHTMAP, MATERIAL_NIGHT_UNIT);
+	program->set(UNIFORM_PECULARMAP, MATERIAL_SPECULAR_UNIT);
+	glUseProgram(0);
+}
+
+int MaterialVariant(const Material *material){
+	// the night side is only lit up on a shaded body
+	if(!material->shade) return MATERIAL_EMISSIVE;
+	return material->night ? MATERIAL_SHADED_NIGHT : MATERIAL_SHADED;
+}
+
+std::string MaterialDefines(int variant){
+	std::string defines;
+	if(variant != MATERIAL_EMISSIVE) defines += "#define SHADED\n";
+	if(variant == MATERIAL_SHADED_NIGHT) defines += "#define NIGHT\n";
+	return defines;
+}
+
+void BindMaterial(const Material *material){
+	BindUnit(MATERIAL_DAY_UNIT, material->day);
+	BindUnit(MATERIAL_NIGHT_UNIT, material->night);
+	BindUnit(MATERIAL_SPECULAR_UNIT, material->specular);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "texture.h"
+#include "shaderprogram.h"
+#include <string>
+
+// --------------------------------------------------------------------------
+// Surface materials of the bodies
+//	Every material texture has a fixed unit, the sampler uniforms of a program
+//	point at those units once after linking. Drawing a body then only binds
+//	its textures to the units, and draws once.
+//	Lighting is not switched by uniforms: the material shaders are compiled
+//	once per variant, one of the feature combinations below that a material
+//	can have, and a body is drawn with the program of its material's variant.
+
+#define MATERIAL_DAY_UNIT 0
+#define MATERIAL_NIGHT_UNIT 1
+#define MATERIAL_SPECULAR_UNIT 2
+
+#define MATERIAL_EMISSIVE 0			//Not lit, defines nothing in the shaders
+#define MATERIAL_SHADED 1			//Lit by the sun, defines SHADED
+#define MATERIAL_SHADED_NIGHT 2		//Plus night side and specular maps, defines both
+#define MATERIAL_VARIANTS 3
+
+struct Material
+{
+	MyTexture *day;
+	MyTexture *night;		//Null if the body has no night side texture
+	MyTexture *specular;	//Null if the body has no specular map, needed with a night texture
+	GLint shade;			//1 if lit by the sun, 0 if emissive
+};
+
+//Points the image, nightmap and pecularmap samplers of a program at the
+//material units
+void SetMaterialSamplers(ShaderProgram *program);
+
+//Variant of the material shaders that draws a material, the features it uses
+int MaterialVariant(const Material *material);
+
+//#define lines of a variant's features, for LoadSource
+std::string MaterialDefines(int variant);
+
+//Binds the textures of a material to their units, textures already on their
+//unit are not bound again
+void BindMaterial(const Material *material);
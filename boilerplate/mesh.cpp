@@ -0,0 +1,553 @@
+#include "mesh.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <thread>
+
+using namespace std;
+using namespace glm;
+
+#define PI_F 3.14159265359f
+
+// Rings filled by a thread at a time, small spheres are not worth splitting
+#define BAND_RINGS 64
+
+// Fills rings [first, last) of the vertex grid, every ring is one row of
+// `columns` vertices. The trig tables hold sin/cos of the ring and segment
+// angles so the inner loop is plain multiplies the compiler can vectorize.
+static void FillSphereRings(vec3* sphere, vec2* texCoord, const float* sinT, const float* cosT,
+							const float* sinP, const float* cosP, int n, int first, int last){
+	int columns = 2*n + 1;
+	for(int i = first; i<last; i++){
+		vec3* row = sphere + i*columns;
+		vec2* rowTex = texCoord + i*columns;
+		float ty = 1.f - float(i)/n;
+		if(i == 0 || i == n){
+			// Poles, one copy per segment centred on its triangle. The last copy
+			// is never referenced and only kept to hold the grid's shape, it
+			// is clamped so every u stays within [0, 1]
+			float y = i == 0 ? 1.f : -1.f;
+			for(int j = 0; j<columns; j++){
+				row[j] = vec3(0.f, y, 0.f);
+				rowTex[j] = vec2(std::min(0.5f*j/n + 0.25f/n, 1.f), ty);
+			}
+			continue;
+		}
+
+		float s = sinT[i], c = cosT[i];
+		for(int j = 0; j<columns; j++){
+			row[j] = vec3(s*cosP[j], c, s*sinP[j]);
+			rowTex[j] = vec2(0.5f*j/n, ty);
+		}
+	}
+}
+
+// Fills the triangles of the quads between rings [first, last) and the next
+// ring. The quads are walked in strips of STRIP_COLUMNS columns going down
+// the band: a row of a strip shares its upper vertices with the row above,
+// so a small FIFO cache loads every vertex about once and the grid needs no
+// OptimizeVertexCache pass.
+#define STRIP_COLUMNS 6		// Two rows of a strip fit in a 16 entry cache with room to spare
+
+static void FillSphereBand(GLuint* indices, GLuint base, int n, int first, int last){
+	int columns = 2*n + 1;
+	// rings before `first` emitted 2n triangles for the north cap and 4n per ring after it
+	GLuint* out = indices + (first == 0 ? 0 : 3*(2*n + 4*n*(first - 1)));
+	for(int strip = 0; strip<2*n; strip += STRIP_COLUMNS){
+		int stripEnd = std::min(strip + STRIP_COLUMNS, 2*n);
+		for(int i = first; i<last; i++){
+			for(int j = strip; j<stripEnd; j++){
+				GLuint a = base + i*columns + j;			// (t, p)
+				GLuint b = base + (i+1)*columns + j;		// (t1, p)
+				GLuint c = base + (i+1)*columns + j + 1;	// (t1, p1)
+				GLuint d = base + i*columns + j + 1;		// (t, p1)
+				if(i == 0){
+					*out++ = a; *out++ = b; *out++ = c;
+				}
+				else if(i == n-1){
+					*out++ = a; *out++ = b; *out++ = d;
+				}
+				else{
+					*out++ = a; *out++ = b; *out++ = c;
+					*out++ = a; *out++ = c; *out++ = d;
+				}
+			}
+		}
+	}
+}
+
+// The pole rings are fans of their own, a sphere needs at least one ring
+// between them. Fewer rings are raised to that minimum.
+#define SPHERE_MIN_RINGS 2
+
+int SphereVertexCount(int n){
+	n = std::max(n, SPHERE_MIN_RINGS);
+	return (n+1)*(2*n + 1);
+}
+
+int SphereIndexCount(int n){
+	n = std::max(n, SPHERE_MIN_RINGS);
+	return 3*4*n*(n-1);
+}
+
+void FillSphere(vec3* sphere, vec2* texCoord, GLuint* indices, GLuint base, int n, int threadCount){
+	n = std::max(n, SPHERE_MIN_RINGS);
+	float step = PI_F/n;
+	int columns = 2*n + 1;		//The seam column is duplicated for the texture coordinates
+
+	vector<float> sinT(n+1), cosT(n+1), sinP(columns), cosP(columns);
+	for(int i = 0; i<=n; i++){
+		sinT[i] = sin(i*step);
+		cosT[i] = cos(i*step);
+	}
+	for(int j = 0; j<columns; j++){
+		sinP[j] = sin(j*step);
+		cosP[j] = cos(j*step);
+	}
+
+	// The rings are cut into bands of BAND_RINGS, every band's vertex rows and
+	// triangles are disjoint from the others' so the threads never synchronise.
+	// The band size is fixed so the triangle order is the same for any thread count.
+	int bandCount = (n + BAND_RINGS - 1)/BAND_RINGS;
+	if(threadCount <= 0) threadCount = std::max(1u, thread::hardware_concurrency());
+	threadCount = std::min(threadCount, bandCount);
+
+	auto work = [=, &sinT, &cosT, &sinP, &cosP](int worker){
+		for(int band = worker; band<bandCount; band += threadCount){
+			int first = band*BAND_RINGS;
+			int last = std::min(first + BAND_RINGS, n);
+			FillSphereRings(sphere, texCoord, sinT.data(), cosT.data(), sinP.data(), cosP.data(), n,
+							first, last == n ? n + 1 : last);
+			FillSphereBand(indices, base, n, first, last);
+		}
+	};
+	vector<thread> workers;
+	for(int worker = 1; worker<threadCount; worker++) workers.push_back(thread(work, worker));
+	work(0);
+	for(size_t w = 0; w<workers.size(); w++) workers[w].join();
+}
+
+void planetMaker(vector<vec3>* sphere, vector<vec2>* texCoord, vector<GLuint>* indices, int n){
+	GLuint base = sphere->size();
+	size_t firstIndex = indices->size();
+
+	sphere->resize(base + SphereVertexCount(n));
+	texCoord->resize(base + SphereVertexCount(n));
+	indices->resize(firstIndex + SphereIndexCount(n));
+	FillSphere(sphere->data() + base, texCoord->data() + base, indices->data() + firstIndex, base, n);
+}
+
+#define RING_SEGMENTS 128
+
+int RingVertexCount(){
+	return 6*RING_SEGMENTS;
+}
+
+void FillRing(vec3* ring, vec2* texCoord){
+	float step = 2*PI_F/RING_SEGMENTS;
+	float in_r = RING_INNER_RADIUS;
+	float out_r = RING_OUTER_RADIUS;
+	for(int k = 0; k<RING_SEGMENTS; k++){
+		float i = k*step;
+		vec3 p1 = vec3(cos(i),0,sin(i)) * in_r;
+		vec3 p2 = vec3(cos(i),0,sin(i)) * out_r;
+		vec3 p3 = vec3(cos(i+step),0,sin(i+step)) * in_r;
+		vec3 p4 = vec3(cos(i+step),0,sin(i+step)) * out_r;
+		*ring++ = p1;
+		*ring++ = p2;
+		*ring++ = p3;
+		*ring++ = p3;
+		*ring++ = p2;
+		*ring++ = p4;
+
+		*texCoord++ = vec2(0.1,0);
+		*texCoord++ = vec2(1,0);
+		*texCoord++ = vec2(0.1,1);
+		*texCoord++ = vec2(0.1,1);
+		*texCoord++ = vec2(1,0);
+		*texCoord++ = vec2(1,1);
+	}
+}
+
+void generateRing(vector<vec3>* ring, vector<vec2>* texCoord){
+	size_t first = ring->size();
+	ring->resize(first + RingVertexCount());
+	texCoord->resize(first + RingVertexCount());
+	FillRing(ring->data() + first, texCoord->data() + first);
+}
+
+// --------------------------------------------------------------------------
+// Sphere generators
+
+#define WELD_EPSILON 1e-5f
+
+// Merges vertices closer than WELD_EPSILON, faces generated on their own
+// repeat the vertices on their shared edges
+static void WeldVertices(vector<vec3>* positions, vector<GLuint>* indices){
+	typedef tuple<int, int, int> Cell;
+	map<Cell, vector<GLuint> > cells;
+	vector<vec3> welded;
+	vector<GLuint> remap(positions->size());
+
+	for(size_t v = 0; v<positions->size(); v++){
+		vec3 p = (*positions)[v];
+		int cx = int(floor(p.x/WELD_EPSILON)), cy = int(floor(p.y/WELD_EPSILON)), cz = int(floor(p.z/WELD_EPSILON));
+
+		// a match can sit in a neighbouring cell when p is close to a cell border
+		int found = -1;
+		for(int dx = -1; dx<=1 && found < 0; dx++)
+		for(int dy = -1; dy<=1 && found < 0; dy++)
+		for(int dz = -1; dz<=1 && found < 0; dz++){
+			map<Cell, vector<GLuint> >::const_iterator cell = cells.find(Cell(cx+dx, cy+dy, cz+dz));
+			if(cell == cells.end()) continue;
+			for(size_t k = 0; k<cell->second.size(); k++){
+				if(length(welded[cell->second[k]] - p) < WELD_EPSILON){
+					found = cell->second[k];
+					break;
+				}
+			}
+		}
+
+		if(found < 0){
+			found = welded.size();
+			welded.push_back(p);
+			cells[Cell(cx, cy, cz)].push_back(found);
+		}
+		remap[v] = found;
+	}
+
+	for(size_t k = 0; k<indices->size(); k++) (*indices)[k] = remap[(*indices)[k]];
+	positions->swap(welded);
+}
+
+// Gives every vertex planetMaker's texture coordinates. Triangles crossing the
+// u = 0/1 seam get copies of their vertices with u - 1, and a vertex on a pole
+// gets one copy per triangle with u in the middle of that triangle.
+static void MapSphereTexCoords(MeshData* mesh){
+	vector<vec3>& positions = mesh->positions;
+	vector<vec2>& texCoords = mesh->texCoords;
+	vector<GLuint>& indices = mesh->indices;
+
+	vector<bool> pole(positions.size());
+	texCoords.resize(positions.size());
+	for(size_t v = 0; v<positions.size(); v++){
+		vec3 p = positions[v];
+		float u = atan2(p.z, p.x)/(2*PI_F);
+		if(u < 0.f) u += 1.f;
+		texCoords[v] = vec2(u, 1.f - acos(clamp(p.y, -1.f, 1.f))/PI_F);
+		pole[v] = p.x*p.x + p.z*p.z < WELD_EPSILON*WELD_EPSILON;
+	}
+
+	map<GLuint, GLuint> wrapped;
+	for(size_t k = 0; k<indices.size(); k += 3){
+		GLuint* tri = &indices[k];
+
+		float minU = 1.f, maxU = 0.f;
+		for(int c = 0; c<3; c++){
+			if(pole[tri[c]]) continue;
+			minU = std::min(minU, texCoords[tri[c]].x);
+			maxU = std::max(maxU, texCoords[tri[c]].x);
+		}
+		if(maxU - minU > 0.5f){
+			for(int c = 0; c<3; c++){
+				if(pole[tri[c]] || texCoords[tri[c]].x < 0.5f) continue;
+				map<GLuint, GLuint>::iterator copy = wrapped.find(tri[c]);
+				if(copy == wrapped.end()){
+					copy = wrapped.insert(make_pair(tri[c], GLuint(positions.size()))).first;
+					positions.push_back(positions[tri[c]]);
+					texCoords.push_back(texCoords[tri[c]] - vec2(1.f, 0.f));
+					pole.push_back(false);
+				}
+				tri[c] = copy->second;
+			}
+		}
+
+		for(int c = 0; c<3; c++){
+			if(!pole[tri[c]]) continue;
+			float u = 0.f;
+			for(int o = 0; o<3; o++)
+				if(o != c) u += 0.5f*texCoords[tri[o]].x;
+			positions.push_back(positions[tri[c]]);
+			texCoords.push_back(vec2(u, texCoords[tri[c]].y));
+			pole.push_back(true);
+			tri[c] = positions.size() - 1;
+		}
+	}
+}
+
+// Welds, maps and optimizes a sphere built face by face, then appends it to mesh
+static void FinishSphere(MeshData* part, MeshData* mesh){
+	WeldVertices(&part->positions, &part->indices);
+	for(size_t v = 0; v<part->positions.size(); v++) part->positions[v] = normalize(part->positions[v]);
+	MapSphereTexCoords(part);
+	OptimizeVertexCache(&part->indices, part->positions.size());
+
+	GLuint base = mesh->positions.size();
+	mesh->positions.insert(mesh->positions.end(), part->positions.begin(), part->positions.end());
+	mesh->texCoords.insert(mesh->texCoords.end(), part->texCoords.begin(), part->texCoords.end());
+	for(size_t k = 0; k<part->indices.size(); k++) mesh->indices.push_back(base + part->indices[k]);
+}
+
+void UVSphereGenerator::generate(MeshData* mesh, int segments) const{
+	planetMaker(&mesh->positions, &mesh->texCoords, &mesh->indices, segments);
+}
+
+bool UVSphereGenerator::size(int segments, int* vertexCount, int* indexCount) const{
+	*vertexCount = SphereVertexCount(segments);
+	*indexCount = SphereIndexCount(segments);
+	return true;
+}
+
+void UVSphereGenerator::fill(vec3* positions, vec2* texCoords, GLuint* indices, int segments) const{
+	FillSphere(positions, texCoords, indices, 0, segments);
+}
+
+// Subdivisions per icosahedron edge and per cube face edge for planetMaker's n,
+// chosen so the longest edge is no longer than the longest edge of the UV
+// sphere (the diagonal of its quads on the equator)
+#define ICOSPHERE_FREQUENCY_SCALE 0.30f
+#define CUBESPHERE_FREQUENCY_SCALE 0.49f
+
+void IcosphereGenerator::generate(MeshData* mesh, int segments) const{
+	const float t = (1.f + sqrt(5.f))/2.f;
+	const vec3 corners[12] = {
+		vec3(-1, t, 0), vec3(1, t, 0), vec3(-1, -t, 0), vec3(1, -t, 0),
+		vec3(0, -1, t), vec3(0, 1, t), vec3(0, -1, -t), vec3(0, 1, -t),
+		vec3(t, 0, -1), vec3(t, 0, 1), vec3(-t, 0, -1), vec3(-t, 0, 1)
+	};
+	const int faces[20][3] = {
+		{0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+		{1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+		{3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+		{4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+	};
+	int f = std::max(1, int(ceil(segments*ICOSPHERE_FREQUENCY_SCALE)));
+
+	MeshData part;
+	part.positions.reserve(20*(f+1)*(f+2)/2);
+	part.indices.reserve(20*3*f*f);
+	for(int face = 0; face<20; face++){
+		vec3 a = normalize(corners[faces[face][0]]);
+		vec3 b = normalize(corners[faces[face][1]]);
+		vec3 c = normalize(corners[faces[face][2]]);
+
+		// Triangular grid, row i holds the f+1-i vertices a + i*(b-a)/f + j*(c-a)/f
+		GLuint base = part.positions.size();
+		vector<GLuint> rowStart(f + 2);
+		for(int i = 0; i<=f; i++){
+			rowStart[i] = part.positions.size() - base;
+			for(int j = 0; j<=f-i; j++)
+				part.positions.push_back(a + (b - a)*(float(i)/f) + (c - a)*(float(j)/f));
+		}
+		for(int i = 0; i<f; i++){
+			for(int j = 0; j<f-i; j++){
+				GLuint v00 = base + rowStart[i] + j;
+				GLuint v10 = base + rowStart[i+1] + j;
+				GLuint v01 = v00 + 1;
+				part.indices.push_back(v00); part.indices.push_back(v10); part.indices.push_back(v01);
+				if(i + j < f - 1){
+					GLuint v11 = v10 + 1;
+					part.indices.push_back(v10); part.indices.push_back(v11); part.indices.push_back(v01);
+				}
+			}
+		}
+	}
+	FinishSphere(&part, mesh);
+}
+
+void CubeSphereGenerator::generate(MeshData* mesh, int segments) const{
+	// normal, then two axes with cross(axisU, axisV) == normal
+	const vec3 faces[6][3] = {
+		{vec3(1, 0, 0), vec3(0, 1, 0), vec3(0, 0, 1)},
+		{vec3(-1, 0, 0), vec3(0, 0, 1), vec3(0, 1, 0)},
+		{vec3(0, 1, 0), vec3(0, 0, 1), vec3(1, 0, 0)},
+		{vec3(0, -1, 0), vec3(1, 0, 0), vec3(0, 0, 1)},
+		{vec3(0, 0, 1), vec3(1, 0, 0), vec3(0, 1, 0)},
+		{vec3(0, 0, -1), vec3(0, 1, 0), vec3(1, 0, 0)}
+	};
+	int m = std::max(1, int(ceil(segments*CUBESPHERE_FREQUENCY_SCALE)));
+
+	MeshData part;
+	part.positions.reserve(6*(m+1)*(m+1));
+	part.indices.reserve(6*6*m*m);
+	for(int face = 0; face<6; face++){
+		GLuint base = part.positions.size();
+		for(int i = 0; i<=m; i++){
+			float a = tan((2.f*i/m - 1.f)*PI_F/4.f);
+			for(int j = 0; j<=m; j++){
+				float b = tan((2.f*j/m - 1.f)*PI_F/4.f);
+				part.positions.push_back(faces[face][0] + a*faces[face][1] + b*faces[face][2]);
+			}
+		}
+		for(int i = 0; i<m; i++){
+			for(int j = 0; j<m; j++){
+				GLuint v00 = base + i*(m+1) + j;
+				GLuint v10 = v00 + m + 1;
+				GLuint v01 = v00 + 1;
+				GLuint v11 = v10 + 1;
+				// cells towards the corners are skewed, split along the shorter diagonal
+				vec3 p00 = normalize(part.positions[v00]), p11 = normalize(part.positions[v11]);
+				vec3 p10 = normalize(part.positions[v10]), p01 = normalize(part.positions[v01]);
+				if(dot(p00, p11) >= dot(p10, p01)){
+					part.indices.push_back(v00); part.indices.push_back(v10); part.indices.push_back(v11);
+					part.indices.push_back(v00); part.indices.push_back(v11); part.indices.push_back(v01);
+				}
+				else{
+					part.indices.push_back(v00); part.indices.push_back(v10); part.indices.push_back(v01);
+					part.indices.push_back(v10); part.indices.push_back(v11); part.indices.push_back(v01);
+				}
+			}
+		}
+	}
+	FinishSphere(&part, mesh);
+}
+
+const MeshGenerator* FindMeshGenerator(const char* name){
+	static const UVSphereGenerator uvSphere;
+	static const IcosphereGenerator icosphere;
+	static const CubeSphereGenerator cubeSphere;
+	const MeshGenerator* generators[] = {&uvSphere, &icosphere, &cubeSphere};
+
+	for(int g = 0; g<3; g++)
+		if(strcmp(generators[g]->name(), name) == 0) return generators[g];
+	return nullptr;
+}
+
+// --------------------------------------------------------------------------
+// Vertex cache optimisation
+//	Scoring constants are the ones from Forsyth's reference description,
+//	the simulated cache is an LRU of CACHE_SIZE entries.
+
+#define CACHE_SIZE 32
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRI_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.f
+#define VALENCE_BOOST_POWER 0.5f
+
+static float vertexScore(int cachePosition, int remainingValence){
+	if(remainingValence == 0) return -1.f;		// No triangle needs this vertex anymore
+
+	float score = 0.f;
+	if(cachePosition >= 0){
+		if(cachePosition < 3){
+			// Used by the last triangle, fixed score so the next one does not
+			// simply reuse the same edge
+			score = LAST_TRI_SCORE;
+		}
+		else{
+			float scaler = 1.f/(CACHE_SIZE - 3);
+			score = pow(1.f - (cachePosition - 3)*scaler, CACHE_DECAY_POWER);
+		}
+	}
+	// Favour vertices with few triangles left so they are finished off early
+	score += VALENCE_BOOST_SCALE * pow(float(remainingValence), -VALENCE_BOOST_POWER);
+	return score;
+}
+
+void OptimizeVertexCache(vector<GLuint>* indices, int vertexCount){
+	int triCount = indices->size()/3;
+	if(triCount == 0) return;
+	const vector<GLuint>& in = *indices;
+
+	// Triangles adjacent to each vertex, the first `remaining[v]` entries of a
+	// vertex's range are the triangles that were not emitted yet
+	vector<int> remaining(vertexCount, 0);
+	for(size_t k = 0; k<in.size(); k++) remaining[in[k]]++;
+	vector<int> adjOffset(vertexCount + 1, 0);
+	for(int v = 0; v<vertexCount; v++) adjOffset[v+1] = adjOffset[v] + remaining[v];
+	vector<int> adjTris(in.size());
+	vector<int> fill(adjOffset.begin(), adjOffset.end() - 1);
+	for(size_t k = 0; k<in.size(); k++) adjTris[fill[in[k]]++] = k/3;
+
+	vector<int> cachePos(vertexCount, -1);
+	vector<float> score(vertexCount);
+	for(int v = 0; v<vertexCount; v++) score[v] = vertexScore(-1, remaining[v]);
+
+	vector<bool> emitted(triCount, false);
+	vector<GLuint> out;
+	out.reserve(in.size());
+	vector<int> cache, newCache;
+	cache.reserve(CACHE_SIZE + 3);
+	newCache.reserve(CACHE_SIZE + 3);
+
+	int bestTri = 0;
+	int scanCursor = 0;		// Fallback when no cached vertex has a triangle left
+	for(int emittedCount = 0; emittedCount<triCount; emittedCount++){
+		if(bestTri < 0){
+			while(emitted[scanCursor]) scanCursor++;
+			bestTri = scanCursor;
+		}
+
+		// Emit the triangle and remove it from its vertices' adjacency
+		emitted[bestTri] = true;
+		for(int k = 0; k<3; k++){
+			GLuint v = in[3*bestTri + k];
+			out.push_back(v);
+			int* tris = &adjTris[adjOffset[v]];
+			for(int a = 0; a<remaining[v]; a++){
+				if(tris[a] == bestTri){
+					tris[a] = tris[remaining[v] - 1];
+					tris[remaining[v] - 1] = bestTri;
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		// Move the triangle's vertices to the front of the cache
+		newCache.clear();
+		for(int k = 0; k<3; k++) newCache.push_back(in[3*bestTri + k]);
+		for(size_t c = 0; c<cache.size(); c++){
+			int v = cache[c];
+			if(v != newCache[0] && v != newCache[1] && v != newCache[2])
+				newCache.push_back(v);
+		}
+		for(size_t c = 0; c<newCache.size(); c++){
+			int v = newCache[c];
+			cachePos[v] = c < CACHE_SIZE ? c : -1;
+			score[v] = vertexScore(cachePos[v], remaining[v]);
+		}
+		if(newCache.size() > CACHE_SIZE) newCache.resize(CACHE_SIZE);
+		cache.swap(newCache);
+
+		// Only triangles touching the cache can have changed their score
+		bestTri = -1;
+		float bestScore = -1.f;
+		for(size_t c = 0; c<cache.size(); c++){
+			int v = cache[c];
+			const int* tris = &adjTris[adjOffset[v]];
+			for(int a = 0; a<remaining[v]; a++){
+				int t = tris[a];
+				float s = score[in[3*t]] + score[in[3*t + 1]] + score[in[3*t + 2]];
+				if(s > bestScore){
+					bestScore = s;
+					bestTri = t;
+				}
+			}
+		}
+	}
+
+	indices->swap(out);
+}
+
+float ComputeACMR(const vector<GLuint>& indices, int cacheSize){
+	if(indices.empty()) return 0.f;
+
+	GLuint maxIndex = 0;
+	for(size_t k = 0; k<indices.size(); k++) maxIndex = std::max(maxIndex, indices[k]);
+
+	// FIFO cache, a vertex is still cached if fewer than cacheSize misses
+	// happened since it was loaded
+	vector<int> loadedAt(maxIndex + 1, -1);
+	int misses = 0;
+	for(size_t k = 0; k<indices.size(); k++){
+		int& loaded = loadedAt[indices[k]];
+		if(loaded < 0 || misses - loaded >= cacheSize){
+			loaded = misses;
+			misses++;
+		}
+	}
+	return float(misses)/(indices.size()/3);
+}
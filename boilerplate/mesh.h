@@ -0,0 +1,121 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// --------------------------------------------------------------------------
+// Functions to generate the meshes used by the planets
+
+//Generates an indexed latitude/longitude sphere of radius 1
+//	Vertices are shared between neighbouring quads, the seam column and the
+//	pole rows are duplicated so every vertex has a single texture coordinate.
+//	The triangle order is optimized for the post-transform vertex cache.
+// ARGS:
+//	sphere - vertex positions are appended here
+//	texCoord - texture coordinates are appended here
+//	indices - triangle list indices are appended here
+//	n - number of rings, the sphere has 2*n segments around, at least 2 (smaller
+//	values are raised to 2)
+void planetMaker(std::vector<glm::vec3>* sphere, std::vector<glm::vec2>* texCoord, std::vector<GLuint>* indices, int n);
+
+//Number of vertices and indices planetMaker appends for n rings
+int SphereVertexCount(int n);
+int SphereIndexCount(int n);
+
+//Writes planetMaker's sphere into preallocated arrays. The sine and cosine
+//of every ring and segment angle are computed once and the rings are split
+//into latitude bands filled in parallel. The output does not depend on the
+//number of threads.
+// ARGS:
+//	sphere, texCoord - SphereVertexCount(n) entries each
+//	indices - SphereIndexCount(n) entries
+//	base - index of the first vertex, added to every index
+//	threadCount - number of threads, 0 to use one per hardware thread
+void FillSphere(glm::vec3* sphere, glm::vec2* texCoord, GLuint* indices, GLuint base, int n, int threadCount = 0);
+
+//Inner and outer radius of the Saturn ring, relative to Saturn's radius
+#define RING_INNER_RADIUS (67300.f/60300.f)
+#define RING_OUTER_RADIUS (140300.f/60300.f)
+
+//Generates the Saturn ring as a triangle soup
+void generateRing(std::vector<glm::vec3>* ring, std::vector<glm::vec2>* texCoord);
+
+//Number of vertices generateRing appends
+int RingVertexCount();
+
+//Writes generateRing's triangle soup into preallocated arrays of RingVertexCount() entries
+void FillRing(glm::vec3* ring, glm::vec2* texCoord);
+
+// --------------------------------------------------------------------------
+// Sphere generators sharing one interface so the planet mesh can be built
+// with any of them. Every generator produces a unit sphere with the same
+// texture mapping as planetMaker (u along the longitude, v = 1 at the north
+// pole) and an indexed, vertex cache optimized triangle list. Vertices on
+// the u = 0/1 seam are duplicated with u < 0, so planet textures should
+// repeat along s. All texture coordinates lie in [-1, 1] and can be packed.
+
+struct MeshData
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> texCoords;
+	std::vector<GLuint> indices;
+};
+
+class MeshGenerator{
+public:
+	virtual ~MeshGenerator() {}
+
+	virtual const char* name() const = 0;
+
+	//Appends a sphere to mesh
+	//	segments - detail in planetMaker's n, the generated triangle edges are
+	//	at most as long as the edges on the equator of planetMaker's sphere
+	virtual void generate(MeshData* mesh, int segments) const = 0;
+
+	//Generators that know their output size without building the mesh return
+	//true and the counts here, fill then writes the same mesh straight into
+	//preallocated (e.g. mapped buffer) arrays with indices starting at 0
+	virtual bool size(int /*segments*/, int* /*vertexCount*/, int* /*indexCount*/) const { return false; }
+	virtual void fill(glm::vec3* /*positions*/, glm::vec2* /*texCoords*/, GLuint* /*indices*/, int /*segments*/) const {}
+};
+
+//Latitude/longitude sphere from planetMaker, 4n(n-1) triangles
+class UVSphereGenerator : public MeshGenerator{
+public:
+	const char* name() const { return "uv"; }
+	void generate(MeshData* mesh, int segments) const;
+	bool size(int segments, int* vertexCount, int* indexCount) const;
+	void fill(glm::vec3* positions, glm::vec2* texCoords, GLuint* indices, int segments) const;
+};
+
+//Icosahedron with every face subdivided into a triangular grid, about 1.8n^2
+//triangles, 45% of the UV sphere's
+class IcosphereGenerator : public MeshGenerator{
+public:
+	const char* name() const { return "ico"; }
+	void generate(MeshData* mesh, int segments) const;
+};
+
+//Cube with every face subdivided into a grid and projected onto the sphere,
+//the grid lines are spaced by equal angles so cells keep a similar size
+//from the centre of a face to its corners, about 2.9n^2 triangles, 72% of
+//the UV sphere's
+class CubeSphereGenerator : public MeshGenerator{
+public:
+	const char* name() const { return "cube"; }
+	void generate(MeshData* mesh, int segments) const;
+};
+
+//Returns the generator with the given name ("uv", "ico" or "cube"), nullptr if unknown
+const MeshGenerator* FindMeshGenerator(const char* name);
+
+//Reorders a triangle list in place to improve post-transform vertex cache
+//hits (Tom Forsyth's linear-speed vertex cache optimisation)
+// ARGS:
+//	indices - triangle list, size must be a multiple of 3
+//	vertexCount - number of vertices referenced by the indices
+void OptimizeVertexCache(std::vector<GLuint>* indices, int vertexCount);
+
+//Average number of vertex shader invocations per triangle for a FIFO cache
+//of the given size, 0.5 is the best case for a closed mesh and 3 the worst
+float ComputeACMR(const std::vector<GLuint>& indices, int cacheSize = 16);
@@ -0,0 +1,114 @@
+#include "meshcache.h"
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+bool CheckGLErrors();
+
+static const char MESH_CACHE_MAGIC[4] = {'M', 'E', 'S', 'H'};
+
+struct MeshCacheHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t headerSize;		//Catches a header layout change without a version bump
+	int32_t elementCount;
+	int32_t indexCount;
+	uint64_t vertexBytes;		//Size of the vertex buffer, the indices follow it
+	VertexFormat format;
+};
+
+bool LoadCachedGeometry(Geometry *geometry, const string& path)
+{
+	int file = open(path.c_str(), O_RDONLY);
+	if(file < 0) return false;
+
+	struct stat info;
+	if(fstat(file, &info) != 0 || size_t(info.st_size) < sizeof(MeshCacheHeader)){
+		close(file);
+		return false;
+	}
+	size_t fileSize = info.st_size;
+	void *mapping = mmap(0, fileSize, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);		// the mapping stays valid without the descriptor
+	if(mapping == MAP_FAILED) return false;
+
+	const char *data = (const char*)mapping;
+	MeshCacheHeader header;
+	memcpy(&header, data, sizeof(header));
+	size_t indexBytes = sizeof(GLuint)*size_t(header.indexCount);
+	bool valid = memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) == 0
+		&& header.version == MESH_CACHE_VERSION && header.headerSize == sizeof(MeshCacheHeader)
+		&& fileSize == sizeof(MeshCacheHeader) + header.vertexBytes + indexBytes;
+
+	if(valid){
+		geometry->elementCount = header.elementCount;
+		geometry->indexCount = header.indexCount;
+		geometry->format = header.format;
+
+		// upload straight from the mapped file
+		glBindVertexArray(geometry->vertexArray);
+		glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, header.vertexBytes, data + sizeof(MeshCacheHeader), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		if(header.indexCount > 0){
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->indexBuffer);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, data + sizeof(MeshCacheHeader) + header.vertexBytes, GL_STATIC_DRAW);
+		}
+		BindVertexFormat(geometry);
+		glBindVertexArray(0);
+		valid = !CheckGLErrors();
+	}
+
+	munmap(mapping, fileSize);
+	return valid;
+}
+
+bool SaveCachedGeometry(const Geometry *geometry, const string& path)
+{
+	GLint vertexBytes = 0;
+	glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
+	glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &vertexBytes);
+
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+	header.version = MESH_CACHE_VERSION;
+	header.headerSize = sizeof(MeshCacheHeader);
+	header.elementCount = geometry->elementCount;
+	header.indexCount = geometry->indexCount;
+	header.vertexBytes = vertexBytes;
+	header.format = geometry->format;
+
+	vector<char> data(sizeof(header) + vertexBytes + sizeof(GLuint)*geometry->indexCount);
+	memcpy(data.data(), &header, sizeof(header));
+	glGetBufferSubData(GL_ARRAY_BUFFER, 0, vertexBytes, data.data() + sizeof(header));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	if(geometry->indexCount > 0){
+		// the element buffer can only be bound through the vertex array object
+		glBindVertexArray(geometry->vertexArray);
+		glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(GLuint)*geometry->indexCount, data.data() + sizeof(header) + vertexBytes);
+		glBindVertexArray(0);
+	}
+	if(CheckGLErrors()) return false;
+
+	// write a temporary file and rename it, a run that is killed halfway
+	// never leaves a truncated cache file behind
+	string temporary = path + ".tmp";
+	FILE *file = fopen(temporary.c_str(), "wb");
+	if(!file) return false;
+	bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+	written = fclose(file) == 0 && written;
+	if(!written || rename(temporary.c_str(), path.c_str()) != 0){
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
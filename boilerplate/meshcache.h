@@ -0,0 +1,20 @@
+#pragma once
+#include "geometry.h"
+#include <string>
+
+// --------------------------------------------------------------------------
+// Binary mesh cache
+//	A cache file holds the vertex and index buffers of a geometry exactly as
+//	they were uploaded, behind a versioned header. Loading maps the file into
+//	memory and uploads straight from the mapping, nothing is parsed or
+//	generated. Files are only valid on the machine that wrote them.
+
+//Bump whenever a generator or the vertex formats change, older files are ignored
+#define MESH_CACHE_VERSION 2
+
+//Fills a geometry created with InitializeVAO from a cache file, returns false
+//if the file is missing, from another version or truncated
+bool LoadCachedGeometry(Geometry *geometry, const std::string& path);
+
+//Writes the buffers of a loaded geometry to a cache file, read back from the GPU
+bool SaveCachedGeometry(const Geometry *geometry, const std::string& path);
@@ -0,0 +1,55 @@
+#include "meshregistry.h"
+#include "meshcache.h"
+#include <iostream>
+#include <sys/stat.h>
+
+using namespace std;
+
+static void ReleaseGeometry(Geometry *geometry)
+{
+	DestroyGeometry(geometry);
+	delete geometry;
+}
+
+MeshHandle MeshRegistry::acquire(const string& name, MeshLoader load){
+	MeshHandle mesh = meshes[name].lock();
+	if(mesh) return mesh;
+
+	mesh = MeshHandle(new Geometry(), ReleaseGeometry);
+	if (!InitializeVAO(mesh.get()))
+		cout << "Program failed to intialize geometry!" << endl;
+
+	string cacheFile = cacheDirectory.empty() ? string() : cacheDirectory + "/" + name + ".mesh";
+	if(!cacheFile.empty() && LoadCachedGeometry(mesh.get(), cacheFile)){
+		cacheHits++;
+	}
+	else{
+		if (!load(mesh.get()))
+			cout << "Failed to load mesh " << name << endl;
+		else if(!cacheFile.empty() && !SaveCachedGeometry(mesh.get(), cacheFile))
+			cout << "Failed to write mesh cache " << cacheFile << endl;
+		uploads++;
+	}
+
+	meshes[name] = mesh;
+	return mesh;
+}
+
+void MeshRegistry::setCacheDirectory(const string& directory){
+	cacheDirectory = directory;
+	if(!directory.empty())
+		mkdir(directory.c_str(), 0755);		// fails harmlessly if it exists
+}
+
+MeshHandle MeshRegistry::find(const string& name) const{
+	map<string, weak_ptr<Geometry> >::const_iterator it = meshes.find(name);
+	if(it == meshes.end()) return MeshHandle();
+	return it->second.lock();
+}
+
+int MeshRegistry::liveCount() const{
+	int count = 0;
+	for(map<string, weak_ptr<Geometry> >::const_iterator it = meshes.begin(); it != meshes.end(); ++it)
+		if(!it->second.expired()) count++;
+	return count;
+}
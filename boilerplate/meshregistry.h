@@ -0,0 +1,46 @@
+#pragma once
+#include "geometry.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+// --------------------------------------------------------------------------
+// Registry handing out shared handles to uploaded meshes
+//	Every distinct mesh is uploaded to the GPU once, the handles are reference
+//	counted and the buffers are destroyed when the last handle is released.
+//	Handles must be released while the OpenGL context is still current.
+//	With a cache directory set, meshes are read from binary cache files named
+//	after the mesh, so the name must encode every parameter of its loader.
+
+typedef std::shared_ptr<Geometry> MeshHandle;
+
+//Fills the buffers of a geometry created by the registry, returns true if successful
+typedef std::function<bool(Geometry *geometry)> MeshLoader;
+
+class MeshRegistry{
+public:
+	MeshRegistry():uploads(0), cacheHits(0)
+			{}
+
+	//Loads meshes from and saves them to cache files in directory, which is
+	//created if missing. An empty directory turns the cache off
+	void setCacheDirectory(const std::string& directory);
+
+	//Returns the mesh registered under name, calling load to create and
+	//upload it only if no handle to it is alive
+	MeshHandle acquire(const std::string& name, MeshLoader load);
+
+	//Returns the mesh registered under name, or an empty handle
+	MeshHandle find(const std::string& name) const;
+
+	int uploadCount() const { return uploads; }	//Number of times a loader was run
+	int cacheHitCount() const { return cacheHits; }	//Number of meshes read from the cache
+	int liveCount() const;						//Number of meshes currently on the GPU
+
+private:
+	std::map<std::string, std::weak_ptr<Geometry> > meshes;
+	std::string cacheDirectory;
+	int uploads;
+	int cacheHits;
+};
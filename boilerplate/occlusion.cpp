@@ -0,0 +1,77 @@
+#include "occlusion.h"
+#include "framestats.h"
+
+using namespace glm;
+
+bool CheckGLErrors();
+
+OcclusionQueries::OcclusionQueries()
+	{}
+
+bool InitializeOcclusionQueries(OcclusionQueries *occlusion, int objectCount){
+	occlusion->queries.assign(objectCount, 0);
+	occlusion->pending.assign(objectCount, 0);
+	occlusion->occluded.assign(objectCount, 0);
+	glGenQueries(objectCount, occlusion->queries.data());
+
+	glGenVertexArrays(1, &occlusion->proxy.vertexArray);
+	occlusion->proxy.elementCount = OCCLUSION_PROXY_VERTICES;
+
+	return !CheckGLErrors();
+}
+
+void ReadOcclusionResults(OcclusionQueries *occlusion){
+	for(size_t object = 0; object < occlusion->queries.size(); object++){
+		if(!occlusion->pending[object]) continue;
+
+		GLuint available = 0;
+		glGetQueryObjectuiv(occlusion->queries[object], GL_QUERY_RESULT_AVAILABLE, &available);
+		if(!available) continue;
+
+		GLuint passed = 0;
+		glGetQueryObjectuiv(occlusion->queries[object], GL_QUERY_RESULT, &passed);
+		occlusion->occluded[object] = passed == 0;
+		occlusion->pending[object] = 0;
+	}
+}
+
+bool Occluded(const OcclusionQueries *occlusion, int object){
+	return occlusion->occluded[object] != 0;
+}
+
+void IssueOcclusionQueries(OcclusionQueries *occlusion, ShaderProgram *program, const UniformBlocks *blocks,
+						   const mat4 *modelMatrices, const bool *tested, vec3 cameraPosition){
+	program->use();
+	glBindVertexArray(occlusion->proxy.vertexArray);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+
+	for(size_t object = 0; object < occlusion->queries.size(); object++){
+		// the faces of a cube around the camera are clipped or behind it, the
+		// cube is rotated with the body so test its circumscribed sphere
+		float radius = length(vec3(modelMatrices[object][0]));
+		bool inside = length(cameraPosition - vec3(modelMatrices[object][3])) <= radius*sqrt(3.f);
+		if(!tested[object] || inside){
+			occlusion->occluded[object] = 0;
+			continue;
+		}
+		if(occlusion->pending[object]) continue;
+
+		BindObjectBlock(blocks, int(object));
+		glBeginQuery(GL_ANY_SAMPLES_PASSED, occlusion->queries[object]);
+		glDrawArrays(GL_TRIANGLES, 0, occlusion->proxy.elementCount);
+		glEndQuery(GL_ANY_SAMPLES_PASSED);
+		occlusion->pending[object] = 1;
+		frameStats.occlusionQueries++;
+	}
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
+
+void DestroyOcclusionQueries(OcclusionQueries *occlusion){
+	glDeleteQueries(GLsizei(occlusion->queries.size()), occlusion->queries.data());
+	DestroyGeometry(&occlusion->proxy);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "geometry.h"
+#include "shaderprogram.h"
+#include "uniformblocks.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+// --------------------------------------------------------------------------
+// Occlusion queries hiding the bodies covered by nearer ones
+//	After the opaque draws of a frame, the cube around each object's sphere
+//	is drawn without writing colour or depth inside an any-samples-passed
+//	query. The next frame reads the results that are ready without waiting
+//	for the GPU, and an object none of whose proxy passed is skipped. An
+//	object still waiting for its result keeps its last state, so a body
+//	coming out from behind another shows up a frame or two late at worst.
+
+#define OCCLUSION_PROXY_VERTICES 36		//Cube around the unit sphere, see occlusion_vertex.glsl
+
+struct OcclusionQueries
+{
+	std::vector<GLuint> queries;		//One per object slot
+	std::vector<char> pending;			//Issued, result not read yet
+	std::vector<char> occluded;			//Last result, 1 if no sample passed
+	Geometry proxy;						//Empty vertex array the cube is drawn from
+
+	OcclusionQueries();
+};
+
+//Creates a query for each of objectCount object block slots
+bool InitializeOcclusionQueries(OcclusionQueries *occlusion, int objectCount);
+
+//Reads the results that are available, never waits for the GPU
+void ReadOcclusionResults(OcclusionQueries *occlusion);
+
+//True if the last result of an object says it is hidden
+bool Occluded(const OcclusionQueries *occlusion, int object);
+
+//Queries every object whose tested flag is set and that has no result
+//pending, against the depth buffer drawn so far. Objects not tested count as
+//visible from now on
+//	cameraPosition - objects whose proxy contains the camera are never occluded
+void IssueOcclusionQueries(OcclusionQueries *occlusion, ShaderProgram *program, const UniformBlocks *blocks,
+						   const glm::mat4 *modelMatrices, const bool *tested, glm::vec3 cameraPosition);
+
+// deallocate the queries and the proxy
+void DestroyOcclusionQueries(OcclusionQueries *occlusion);
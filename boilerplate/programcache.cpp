@@ -0,0 +1,177 @@
+#include "programcache.h"
+#include <GLFW/glfw3.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdint.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// the loader only covers GL 4.0, the rest is looked up at runtime
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+static GetProgramBinaryProc getProgramBinary = 0;
+static ProgramBinaryProc programBinary = 0;
+static ProgramParameteriProc programParameteri = 0;
+
+// empty while the cache is off
+static string cacheDirectory;
+static string driver;
+
+static const char PROGRAM_CACHE_MAGIC[4] = {'P', 'R', 'O', 'G'};
+
+struct ProgramCacheHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t headerSize;		//Catches a header layout change without a version bump
+	uint32_t binaryFormat;
+	uint64_t binaryBytes;
+};
+
+//64 bit FNV-1a, continuing from hash
+static uint64_t Hash(const void *data, size_t size, uint64_t hash){
+	const unsigned char *bytes = (const unsigned char*)data;
+	for(size_t i = 0; i < size; i++){
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+//Drops errors left by earlier calls, so the next glGetError only reports the
+//call it checks
+static void ClearGLErrors(){
+	while(glGetError() != GL_NO_ERROR) {}
+}
+
+static string CacheFile(const string& key){
+	return cacheDirectory + "/" + key + ".program";
+}
+
+bool InitializeProgramCache(const string& directory){
+	cacheDirectory.clear();
+
+	getProgramBinary = (GetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+	programBinary = (ProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+	programParameteri = (ProgramParameteriProc)glfwGetProcAddress("glProgramParameteri");
+	if(!getProgramBinary || !programBinary || !programParameteri) return false;
+
+	// some drivers expose the functions but cannot save any program
+	GLint formats = 0;
+	ClearGLErrors();
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if(glGetError() != GL_NO_ERROR || formats == 0 || directory.empty()) return false;
+
+	// a binary only loads into the driver that wrote it
+	const GLubyte *strings[3] = {glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION)};
+	driver.clear();
+	for(int s = 0; s < 3; s++){
+		if(strings[s]) driver += reinterpret_cast<const char*>(strings[s]);
+		driver += '\n';
+	}
+
+	mkdir(directory.c_str(), 0755);		// fails harmlessly if it exists
+	cacheDirectory = directory;
+	return true;
+}
+
+string ProgramCacheKey(const vector<string>& sources){
+	if(cacheDirectory.empty()) return string();
+
+	// each source is preceded by its length, so moving text between stages
+	// changes the key
+	uint64_t hash = Hash(driver.data(), driver.size(), 14695981039346656037ull);
+	for(size_t s = 0; s < sources.size(); s++){
+		uint64_t length = sources[s].size();
+		hash = Hash(&length, sizeof(length), hash);
+		hash = Hash(sources[s].data(), sources[s].size(), hash);
+	}
+
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+	return key;
+}
+
+GLuint LoadCachedProgram(const string& key){
+	if(key.empty()) return 0;
+
+	FILE *file = fopen(CacheFile(key).c_str(), "rb");
+	if(!file) return 0;
+
+	ProgramCacheHeader header;
+	vector<char> binary;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic)) == 0
+		&& header.version == PROGRAM_CACHE_VERSION && header.headerSize == sizeof(ProgramCacheHeader)
+		&& header.binaryBytes > 0 && header.binaryBytes < (1u << 30);
+	if(valid){
+		binary.resize(header.binaryBytes);
+		valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+	}
+	fclose(file);
+	if(!valid) return 0;
+
+	// the driver checks the binary and fails the link status if it refuses it
+	GLuint program = glCreateProgram();
+	ClearGLErrors();
+	programBinary(program, header.binaryFormat, binary.data(), GLsizei(binary.size()));
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if(glGetError() != GL_NO_ERROR || status == GL_FALSE){
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void RetainProgramBinary(GLuint program){
+	if(!cacheDirectory.empty())
+		programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool SaveCachedProgram(GLuint program, const string& key){
+	if(key.empty()) return false;
+
+	GLint status = GL_FALSE, length = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(status == GL_FALSE || length <= 0) return false;
+
+	ProgramCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+	header.version = PROGRAM_CACHE_VERSION;
+	header.headerSize = sizeof(ProgramCacheHeader);
+
+	vector<char> data(sizeof(header) + length);
+	GLenum format = 0;
+	GLsizei written = 0;
+	ClearGLErrors();
+	getProgramBinary(program, length, &written, &format, data.data() + sizeof(header));
+	if(glGetError() != GL_NO_ERROR || written <= 0) return false;
+	header.binaryFormat = format;
+	header.binaryBytes = written;
+	memcpy(data.data(), &header, sizeof(header));
+	data.resize(sizeof(header) + written);
+
+	// write a temporary file and rename it, as the mesh cache does
+	string path = CacheFile(key);
+	string temporary = path + ".tmp";
+	FILE *file = fopen(temporary.c_str(), "wb");
+	if(!file) return false;
+	bool saved = fwrite(data.data(), 1, data.size(), file) == data.size();
+	saved = fclose(file) == 0 && saved;
+	if(!saved || rename(temporary.c_str(), path.c_str()) != 0){
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
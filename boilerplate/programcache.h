@@ -0,0 +1,36 @@
+#pragma once
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------------------------
+// Program binary cache
+//	A linked program is saved with glGetProgramBinary under a key hashed from
+//	its shader sources, as passed to the compiler, and the vendor, renderer
+//	and version strings of the driver. A later run with the same key loads the
+//	binary with glProgramBinary and skips compiling and linking. The driver
+//	may still reject a binary, e.g. after an update that kept its version
+//	string, the program is then built from source and the file rewritten.
+//	Binaries need GL 4.1 or ARB_get_program_binary, and a driver offering at
+//	least one binary format.
+
+//Bump whenever the file layout changes, older files are ignored
+#define PROGRAM_CACHE_VERSION 1
+
+//Looks up the binary program functions and creates the cache directory,
+//returns false if the context cannot save programs, which turns the cache off
+bool InitializeProgramCache(const std::string& directory);
+
+//Key of a program built from the given sources, one per stage in the order
+//they are attached, empty with the cache off
+std::string ProgramCacheKey(const std::vector<std::string>& sources);
+
+//Program loaded from the cache file of a key, 0 if there is none or the
+//driver rejects it
+GLuint LoadCachedProgram(const std::string& key);
+
+//Asks the driver to keep the binary of a program, call before linking it
+void RetainProgramBinary(GLuint program);
+
+//Writes the binary of a successfully linked program to the file of a key
+bool SaveCachedProgram(GLuint program, const std::string& key);
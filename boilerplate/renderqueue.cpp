@@ -0,0 +1,124 @@
+#include "renderqueue.h"
+#include "framestats.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+bool CheckGLErrors();
+
+//Id of a state object, new ones get the next id, wrapping at the field width
+template<typename T>
+static unsigned StateId(unordered_map<T, unsigned>& ids, T state, int bits){
+	typename unordered_map<T, unsigned>::iterator it = ids.find(state);
+	if(it != ids.end()) return it->second;
+	unsigned id = unsigned(ids.size()) & ((1u << bits) - 1);
+	ids[state] = id;
+	return id;
+}
+
+//Packs the pass, depth and state of an item into its sort key
+static void Enqueue(RenderQueue *queue, DrawItem item, float depth, int pass){
+	uint64_t program = StateId<const void*>(queue->programIds, item.program, RENDER_KEY_PROGRAM_BITS);
+	uint64_t material = StateId<const void*>(queue->materialIds, item.material, RENDER_KEY_MATERIAL_BITS);
+	uint64_t mesh = StateId<GLuint>(queue->meshIds, item.vertexArray, RENDER_KEY_MESH_BITS);
+
+	// the bits of a non-negative float sort in the same order as its value
+	uint32_t depthBits;
+	depth = max(depth, 0.f);
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	int shift = 64 - RENDER_KEY_PASS_BITS;
+	item.key = uint64_t(pass) << shift;
+	shift -= RENDER_KEY_DEPTH_BITS;
+	item.key |= uint64_t(depthBits >> (32 - RENDER_KEY_DEPTH_BITS)) << shift;
+	shift -= RENDER_KEY_PROGRAM_BITS;
+	item.key |= program << shift;
+	shift -= RENDER_KEY_MATERIAL_BITS;
+	item.key |= material << shift;
+	shift -= RENDER_KEY_MESH_BITS;
+	item.key |= mesh << shift;
+	queue->items.push_back(item);
+}
+
+void ClearRenderQueue(RenderQueue *queue){
+	queue->items.clear();
+}
+
+void SubmitGeometry(RenderQueue *queue, ShaderProgram *program, const Material *material, Geometry *geometry,
+					int object, GLenum rendermode, float depth, int pass){
+	DrawItem item = {0, program, material, geometry, 0, 0, 0, geometry->vertexArray, object, rendermode};
+	Enqueue(queue, item, depth, pass);
+}
+
+void SubmitTerrain(RenderQueue *queue, ShaderProgram *program, const Material *material, Terrain *terrain,
+				   int object, float depth){
+	DrawItem item = {0, program, material, 0, terrain, 0, 0, terrain->geometry.vertexArray, object, GL_TRIANGLES};
+	Enqueue(queue, item, depth, RENDER_PASS_OPAQUE);
+}
+
+void SubmitInstances(RenderQueue *queue, ShaderProgram *program, InstanceBatch *batch, GLenum rendermode, float depth){
+	if(batch->instanceCount == 0) return;
+	DrawItem item = {0, program, 0, 0, 0, batch, 0, batch->vertexArray, -1, rendermode};
+	Enqueue(queue, item, depth, RENDER_PASS_OPAQUE);
+}
+
+void SubmitIndirect(RenderQueue *queue, ShaderProgram *program, IndirectBatch *indirect, GLenum rendermode, float depth){
+	if(indirect->drawCount == 0) return;
+	DrawItem item = {0, program, 0, 0, 0, 0, indirect, indirect->geometry.vertexArray, -1, rendermode};
+	Enqueue(queue, item, depth, RENDER_PASS_OPAQUE);
+}
+
+void ExecuteRenderQueue(RenderQueue *queue, const UniformBlocks *blocks){
+	stable_sort(queue->items.begin(), queue->items.end(),
+				[](const DrawItem& a, const DrawItem& b){ return a.key < b.key; });
+
+	ShaderProgram *program = 0;
+	const Material *material = 0;
+	GLuint vertexArray = 0;
+	int object = -1;
+	for(size_t i = 0; i < queue->items.size(); i++){
+		const DrawItem& item = queue->items[i];
+
+		if(item.program != program){
+			item.program->use();
+			program = item.program;
+			frameStats.stateChanges++;
+		}
+		// the material textures sit on fixed units shared by every program
+		if(item.material && item.material != material){
+			BindMaterial(item.material);
+			material = item.material;
+			frameStats.stateChanges++;
+		}
+		if(item.vertexArray != vertexArray){
+			glBindVertexArray(item.vertexArray);
+			vertexArray = item.vertexArray;
+			frameStats.stateChanges++;
+		}
+		if(item.object >= 0 && item.object != object){
+			BindObjectBlock(blocks, item.object);
+			object = item.object;
+			frameStats.stateChanges++;
+		}
+
+		if(item.batch)
+			DrawInstances(item.batch, item.rendermode);
+		else if(item.indirect)
+			DrawIndirect(item.indirect, item.rendermode);
+		else if(item.terrain)
+			DrawTerrain(item.terrain, item.rendermode);
+		else{
+			// only used by the procedural and tessellated sphere programs
+			item.program->set(UNIFORM_SEGMENTS, item.geometry->segments);
+			DrawGeometry(item.geometry, item.rendermode);
+		}
+	}
+
+	// reset state to default (no shader or geometry bound)
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	// check for an report any OpenGL errors
+	CheckGLErrors();
+}
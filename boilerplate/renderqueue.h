@@ -0,0 +1,83 @@
+#pragma once
+#include "geometry.h"
+#include "indirect.h"
+#include "instancing.h"
+#include "material.h"
+#include "shaderprogram.h"
+#include "terrain.h"
+#include "uniformblocks.h"
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------------------------
+// Render queue sorted to minimize state changes
+//	Draws are submitted in any order with a sort key packing their pass,
+//	depth, program, material and vertex array, most significant first. The
+//	opaque pass is drawn front to back so the depth test rejects hidden
+//	fragments before they are shaded, draws at about the same depth are
+//	grouped by state. The sky pass is drawn last, on the far plane.
+//	A program, material, vertex array or object range already bound is not
+//	bound again. Every bind that does happen counts as a state change.
+
+#define RENDER_PASS_OPAQUE 0
+#define RENDER_PASS_SKY 1
+
+//Bits of the sort key, from the most significant, the low bits are unused
+#define RENDER_KEY_PASS_BITS 4
+#define RENDER_KEY_DEPTH_BITS 16		//Top bits of the float, about 1% steps of the distance
+#define RENDER_KEY_PROGRAM_BITS 8
+#define RENDER_KEY_MATERIAL_BITS 12
+#define RENDER_KEY_MESH_BITS 12
+
+//Draw waiting in the queue, exactly one of geometry, terrain, batch and
+//indirect is set
+struct DrawItem
+{
+	uint64_t         key;
+	ShaderProgram   *program;
+	const Material  *material;		//Null for instance and indirect batches, which sample the texture array
+	Geometry        *geometry;
+	Terrain         *terrain;
+	InstanceBatch   *batch;
+	IndirectBatch   *indirect;
+	GLuint           vertexArray;
+	int              object;		//Slot of the object block, -1 if the draw reads none
+	GLenum           rendermode;
+};
+
+struct RenderQueue
+{
+	std::vector<DrawItem> items;
+
+	// small ids of the programs, materials and vertex arrays seen so far,
+	// kept across frames so the order of equal keys stays the same
+	std::unordered_map<const void*, unsigned> programIds;
+	std::unordered_map<const void*, unsigned> materialIds;
+	std::unordered_map<GLuint, unsigned> meshIds;
+};
+
+//Empties the queue, call at the start of every frame
+void ClearRenderQueue(RenderQueue *queue);
+
+//Queues a draw of a geometry with the model matrix of an object slot
+//	depth - distance from the camera to the nearest part, nearer draws sort first
+//	pass - RENDER_PASS_ value
+void SubmitGeometry(RenderQueue *queue, ShaderProgram *program, const Material *material, Geometry *geometry,
+					int object, GLenum rendermode, float depth, int pass = RENDER_PASS_OPAQUE);
+
+//Queues the chunks picked by the last UpdateTerrain
+void SubmitTerrain(RenderQueue *queue, ShaderProgram *program, const Material *material, Terrain *terrain,
+				   int object, float depth);
+
+//Queues an instanced draw of every instance of a batch
+//	depth - distance from the camera to the nearest instance
+void SubmitInstances(RenderQueue *queue, ShaderProgram *program, InstanceBatch *batch, GLenum rendermode, float depth);
+
+//Queues one multi-draw of every draw of an indirect batch
+//	depth - distance from the camera to the nearest draw
+void SubmitIndirect(RenderQueue *queue, ShaderProgram *program, IndirectBatch *indirect, GLenum rendermode, float depth);
+
+//Sorts the queue and draws it, the frame block must be bound and the object
+//block filled
+void ExecuteRenderQueue(RenderQueue *queue, const UniformBlocks *blocks);
@@ -0,0 +1,125 @@
+#include "shaderprogram.h"
+#include "framestats.h"
+#include "uniformblocks.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace glm;
+
+// names of the resolved uniforms, in the order of UniformName
+static const char* UNIFORM_NAMES[UNIFORM_COUNT] = {
+	"segments", "image", "nightmap", "pecularmap", "layers"
+};
+
+//Drops the "[0]" GL appends to the name of an array
+static string BaseName(const char *name){
+	string base(name);
+	size_t bracket = base.find('[');
+	if(bracket != string::npos) base.erase(bracket);
+	return base;
+}
+
+//Points a uniform block of the program at a binding, if the program uses it
+static void BindBlock(GLuint program, const char *name, GLuint binding){
+	GLuint index = glGetUniformBlockIndex(program, name);
+	if(index != GL_INVALID_INDEX) glUniformBlockBinding(program, index, binding);
+}
+
+bool ShaderProgram::reflect(GLuint program){
+	id = program;
+	uniforms.clear();
+	attributes.clear();
+	values.clear();
+	fill(locations, locations + UNIFORM_COUNT, -1);
+	if(program == 0) return false;
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if(linked == GL_FALSE){
+		glDeleteProgram(program);
+		id = 0;
+		return false;
+	}
+
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	vector<char> name(maxLength + 1);
+	GLint lastLocation = -1;
+	for(GLint u = 0; u < count; u++){
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(program, u, GLsizei(name.size()), 0, &size, &type, name.data());
+		GLint location = glGetUniformLocation(program, name.data());
+		if(location < 0) continue;		// member of a uniform block
+		uniforms[BaseName(name.data())] = location;
+		lastLocation = std::max(lastLocation, location + size - 1);
+	}
+	UniformValue unset = {0, {0}};
+	values.assign(lastLocation + 1, unset);
+
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+	name.assign(maxLength + 1, 0);
+	for(GLint a = 0; a < count; a++){
+		GLint size;
+		GLenum type;
+		glGetActiveAttrib(program, a, GLsizei(name.size()), 0, &size, &type, name.data());
+		attributes[BaseName(name.data())] = glGetAttribLocation(program, name.data());
+	}
+
+	for(int u = 0; u < UNIFORM_COUNT; u++)
+		locations[u] = uniformLocation(UNIFORM_NAMES[u]);
+
+	BindBlock(program, "FrameBlock", FRAME_BLOCK_BINDING);
+	BindBlock(program, "ObjectBlock", OBJECT_BLOCK_BINDING);
+	return true;
+}
+
+GLint ShaderProgram::uniformLocation(const string& name) const{
+	map<string, GLint>::const_iterator it = uniforms.find(name);
+	return it == uniforms.end() ? -1 : it->second;
+}
+
+GLint ShaderProgram::attributeLocation(const string& name) const{
+	map<string, GLint>::const_iterator it = attributes.find(name);
+	return it == attributes.end() ? -1 : it->second;
+}
+
+bool ShaderProgram::changed(GLint location, const void *value, int words){
+	if(location < 0 || size_t(location) >= values.size()) return false;
+	UniformValue& cached = values[location];
+	if(cached.words == words && memcmp(cached.data, value, 4*words) == 0)
+		return false;
+	cached.words = words;
+	memcpy(cached.data, value, 4*words);
+	frameStats.uniformUploads++;
+	return true;
+}
+
+void ShaderProgram::setUniform(GLint location, GLint value){
+	if(changed(location, &value, 1)) glUniform1i(location, value);
+}
+
+void ShaderProgram::setUniform(GLint location, GLfloat value){
+	if(changed(location, &value, 1)) glUniform1f(location, value);
+}
+
+void ShaderProgram::setUniform(GLint location, const vec2& value){
+	if(changed(location, value_ptr(value), 2)) glUniform2fv(location, 1, value_ptr(value));
+}
+
+void ShaderProgram::setUniform(GLint location, const vec3& value){
+	if(changed(location, value_ptr(value), 3)) glUniform3fv(location, 1, value_ptr(value));
+}
+
+void ShaderProgram::setUniform(GLint location, const mat4& value){
+	if(changed(location, value_ptr(value), 16)) glUniformMatrix4fv(location, 1, false, value_ptr(value));
+}
+
+void ShaderProgram::destroy(){
+	glDeleteProgram(id);
+	reflect(0);
+}
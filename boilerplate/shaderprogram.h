@@ -0,0 +1,78 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------------------------
+// Linked shader program and its active uniforms and attributes
+//	The program is reflected once after linking. The uniforms set while
+//	drawing are resolved into a table so setting them needs no string lookup,
+//	and a value equal to the one last uploaded to a location is skipped.
+//	The FrameBlock and ObjectBlock uniform blocks are bound to the binding
+//	points of uniformblocks.h.
+
+//Uniforms resolved at link time, setting one the program lacks does nothing
+enum UniformName{
+	UNIFORM_SEGMENTS,
+	UNIFORM_IMAGE,
+	UNIFORM_NIGHTMAP,
+	UNIFORM_PECULARMAP,
+	UNIFORM_LAYERS,
+	UNIFORM_COUNT
+};
+
+class ShaderProgram{
+public:
+	ShaderProgram():id(0)
+			{ std::fill(locations, locations + UNIFORM_COUNT, -1); }
+
+	//Takes over a program and reflects it, returns false for program 0 or one
+	//that failed to link, which is deleted and leaves no uniforms to set
+	bool reflect(GLuint program);
+
+	GLuint handle() const { return id; }
+	void use() const { glUseProgram(id); }
+
+	//Location of an active uniform or vertex attribute, -1 if there is none by that name
+	GLint uniformLocation(const std::string& name) const;
+	GLint attributeLocation(const std::string& name) const;
+
+	//Setters of the resolved uniforms, the program must be in use
+	void set(UniformName uniform, GLint value) { setUniform(locations[uniform], value); }
+	void set(UniformName uniform, GLfloat value) { setUniform(locations[uniform], value); }
+	void set(UniformName uniform, const glm::vec2& value) { setUniform(locations[uniform], value); }
+	void set(UniformName uniform, const glm::vec3& value) { setUniform(locations[uniform], value); }
+	void set(UniformName uniform, const glm::mat4& value) { setUniform(locations[uniform], value); }
+
+	//Setters taking a location from uniformLocation, for uniforms set at
+	//startup, a location of -1 sets nothing
+	void setUniform(GLint location, GLint value);
+	void setUniform(GLint location, GLfloat value);
+	void setUniform(GLint location, const glm::vec2& value);
+	void setUniform(GLint location, const glm::vec3& value);
+	void setUniform(GLint location, const glm::mat4& value);
+
+	// deallocate the program
+	void destroy();
+
+private:
+	//Last value uploaded to a location, as raw 32 bit words
+	struct UniformValue
+	{
+		int words;				//0 until the location is first set
+		GLfloat data[16];
+	};
+
+	//Returns true if value differs from the cached one at location and caches
+	//it, counting the upload
+	bool changed(GLint location, const void *value, int words);
+
+	GLuint id;
+	GLint locations[UNIFORM_COUNT];
+	std::map<std::string, GLint> uniforms;
+	std::map<std::string, GLint> attributes;
+	std::vector<UniformValue> values;		//Indexed by location
+};
@@ -0,0 +1,120 @@
+#include "streambuffer.h"
+#include <GLFW/glfw3.h>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+bool CheckGLErrors();
+
+// the loader only covers GL 4.0, buffer storage is looked up at runtime
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+//Bytes of the persistent buffer, all regions
+#define STREAM_BUFFER_BYTES (STREAM_FRAMES*STREAM_FRAME_BYTES)
+
+StreamBuffer::StreamBuffer() : buffer(0), persistent(false), mapped(0), region(0), used(0)
+{
+	for(int i = 0; i < STREAM_FRAMES; i++) fences[i] = 0;
+}
+
+//True if the context has GL 4.4 or lists ARB_buffer_storage
+static bool HasBufferStorage(){
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if(major > 4 || (major == 4 && minor >= 4)) return true;
+
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for(GLint i = 0; i < count; i++){
+		if(strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), "GL_ARB_buffer_storage") == 0) return true;
+	}
+	return false;
+}
+
+bool InitializeStreamBuffer(StreamBuffer *stream){
+	glGenBuffers(1, &stream->buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, stream->buffer);
+
+	BufferStorageProc bufferStorage = HasBufferStorage() ? (BufferStorageProc)glfwGetProcAddress("glBufferStorage") : 0;
+	if(bufferStorage){
+		// coherent, so writes need no explicit flush before the draws
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		bufferStorage(GL_ARRAY_BUFFER, STREAM_BUFFER_BYTES, 0, flags);
+		stream->mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, STREAM_BUFFER_BYTES, flags));
+		stream->persistent = stream->mapped != 0;
+	}
+	if(!stream->persistent){
+		glBufferData(GL_ARRAY_BUFFER, STREAM_FRAME_BYTES, 0, GL_STREAM_DRAW);
+		stream->staging.resize(STREAM_FRAME_BYTES);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	cout << "Streaming buffer: " << (stream->persistent ? "persistently mapped" : "orphaned every frame") << endl;
+	return !CheckGLErrors();
+}
+
+void BeginStreamFrame(StreamBuffer *stream){
+	stream->used = 0;
+	if(!stream->persistent) return;
+
+	stream->region = (stream->region + 1) % STREAM_FRAMES;
+	GLsync& fence = stream->fences[stream->region];
+	if(fence){
+		// normally signaled long ago, the region was last drawn STREAM_FRAMES frames back
+		while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+			;
+		glDeleteSync(fence);
+		fence = 0;
+	}
+}
+
+GLintptr StreamWrite(StreamBuffer *stream, const void *data, GLsizeiptr size, GLint alignment){
+	GLintptr offset = (stream->used + alignment - 1)/alignment*alignment;
+	if(offset + size > STREAM_FRAME_BYTES){
+		cout << "Streaming buffer full, " << size << " bytes dropped" << endl;
+		return -1;
+	}
+	stream->used = offset + size;
+
+	if(stream->persistent){
+		offset += GLintptr(stream->region)*STREAM_FRAME_BYTES;
+		memcpy(stream->mapped + offset, data, size);
+	}
+	else
+		memcpy(&stream->staging[offset], data, size);
+	return offset;
+}
+
+void FlushStreamBuffer(StreamBuffer *stream){
+	if(stream->persistent || stream->used == 0) return;
+
+	// orphan last frame's contents so the driver does not wait for its draws
+	glBindBuffer(GL_ARRAY_BUFFER, stream->buffer);
+	glBufferData(GL_ARRAY_BUFFER, STREAM_FRAME_BYTES, 0, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, stream->used, stream->staging.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void EndStreamFrame(StreamBuffer *stream){
+	if(stream->persistent)
+		stream->fences[stream->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void DestroyStreamBuffer(StreamBuffer *stream){
+	for(int i = 0; i < STREAM_FRAMES; i++){
+		if(stream->fences[i]) glDeleteSync(stream->fences[i]);
+		stream->fences[i] = 0;
+	}
+	if(stream->persistent){
+		glBindBuffer(GL_ARRAY_BUFFER, stream->buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	glDeleteBuffers(1, &stream->buffer);
+}
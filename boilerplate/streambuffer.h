@@ -0,0 +1,51 @@
+#pragma once
+#include <glad/glad.h>
+#include <vector>
+
+// --------------------------------------------------------------------------
+// Streaming buffer for the data written every frame
+//	The uniform blocks, instance data and indirect draws of a frame are all
+//	written into one buffer, split into STREAM_FRAMES regions used in turn.
+//	With ARB_buffer_storage (GL 4.4) the buffer stays persistently mapped and
+//	the CPU writes straight into the region of the current frame. A fence
+//	placed after the draws of a frame keeps its region from being written
+//	again while the GPU still reads it, and with three regions the wait is
+//	normally over before it starts.
+//	Without buffer storage, e.g. on a 4.1 context, the frame is written to a
+//	copy in memory and uploaded into an orphaned buffer before drawing.
+
+#define STREAM_FRAMES 3					//Frames that can be in flight
+#define STREAM_FRAME_BYTES (256*1024)	//Room for the data of one frame
+
+struct StreamBuffer
+{
+	GLuint buffer;
+	bool persistent;			//Mapped with buffer storage, otherwise orphaned
+	char *mapped;				//Start of the persistent mapping
+	int region;					//Region written this frame
+	GLintptr used;				//Bytes of the region written so far
+	GLsync fences[STREAM_FRAMES];	//Set once the GPU is done with a region, 0 if none is pending
+	std::vector<char> staging;	//Data of the frame when orphaning
+
+	StreamBuffer();
+};
+
+//Creates the buffer, persistently mapped if the context has buffer storage
+bool InitializeStreamBuffer(StreamBuffer *stream);
+
+//Moves to the next region and waits until the GPU is done reading it
+void BeginStreamFrame(StreamBuffer *stream);
+
+//Copies data into the current region and returns its offset in the buffer,
+//-1 if the region is full
+//	alignment - the offset is a multiple of it, e.g. GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+GLintptr StreamWrite(StreamBuffer *stream, const void *data, GLsizeiptr size, GLint alignment);
+
+//Makes the data written this frame visible to the GPU, call before drawing
+void FlushStreamBuffer(StreamBuffer *stream);
+
+//Fences the region after the last draw reading it was submitted
+void EndStreamFrame(StreamBuffer *stream);
+
+// deallocate the buffer and pending fences
+void DestroyStreamBuffer(StreamBuffer *stream);
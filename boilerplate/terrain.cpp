@@ -0,0 +1,358 @@
+#include "terrain.h"
+#include "framestats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+using namespace std;
+using namespace glm;
+
+bool CheckGLErrors();
+
+#define PI_F 3.14159265359f
+
+static const int CHUNK_SIDE = TERRAIN_CHUNK_GRID + 1;						// vertices along a side
+static const int CHUNK_VERTICES = CHUNK_SIDE*CHUNK_SIDE + 4*CHUNK_SIDE;		// grid, then the 4 skirts
+static const int CHUNK_INDICES = 6*TERRAIN_CHUNK_GRID*TERRAIN_CHUNK_GRID + 4*6*TERRAIN_CHUNK_GRID;
+
+// the quadtrees start one level below whole faces, a chunk covering a whole
+// pole face would span every longitude and cross the texture seam
+static const int ROOT_LEVEL = 1;
+static const int ROOT_CHUNKS = 6*4;
+
+// cube faces: outward normal, then the two axes spanning the face, their
+// cross product is the normal so the grid triangles wind outwards
+static const vec3 FACE_AXES[6][3] = {
+	{vec3( 1, 0, 0), vec3( 0, 0,-1), vec3(0, 1, 0)},
+	{vec3(-1, 0, 0), vec3( 0, 0, 1), vec3(0, 1, 0)},
+	{vec3( 0, 1, 0), vec3( 1, 0, 0), vec3(0, 0,-1)},
+	{vec3( 0,-1, 0), vec3( 1, 0, 0), vec3(0, 0, 1)},
+	{vec3( 0, 0, 1), vec3( 1, 0, 0), vec3(0, 1, 0)},
+	{vec3( 0, 0,-1), vec3(-1, 0, 0), vec3(0, 1, 0)}
+};
+
+Terrain::Terrain() : frame(0), quit(false)
+	{}
+
+// --------------------------------------------------------------------------
+// Chunks
+//	A chunk key packs the face, the level and the position of the chunk on
+//	its face, counted in chunks of that level from the corner of the face.
+
+static uint64_t ChunkKey(int face, int level, uint32_t x, uint32_t y){
+	return (uint64_t(face) << 56) | (uint64_t(level) << 48) | (uint64_t(x) << 24) | uint64_t(y);
+}
+
+static int KeyFace(uint64_t key){ return int(key >> 56); }
+static int KeyLevel(uint64_t key){ return int((key >> 48) & 0xff); }
+static uint32_t KeyX(uint64_t key){ return uint32_t((key >> 24) & 0xffffff); }
+static uint32_t KeyY(uint64_t key){ return uint32_t(key & 0xffffff); }
+
+//Arc length of a chunk side on the unit sphere, about the same everywhere on a face
+static float ChunkArc(int level){
+	return 0.5f*PI_F/float(1 << level);
+}
+
+//Point of the unit sphere at face coordinates (a, b) in [-1, 1]
+static vec3 FacePoint(int face, float a, float b){
+	// the tangent warp spreads the vertices evenly, like the cube sphere generator
+	a = tan(a*PI_F/4.f);
+	b = tan(b*PI_F/4.f);
+	return normalize(FACE_AXES[face][0] + a*FACE_AXES[face][1] + b*FACE_AXES[face][2]);
+}
+
+static vec3 ChunkCentre(uint64_t key){
+	float size = 2.f/float(1 << KeyLevel(key));
+	return FacePoint(KeyFace(key), -1.f + (KeyX(key) + 0.5f)*size, -1.f + (KeyY(key) + 0.5f)*size);
+}
+
+//Same texture coordinates as planetMaker's sphere, with u moved by whole
+//turns to lie within half a turn of nearU so no triangle spans the seam
+static vec2 SphereTexCoord(vec3 point, float nearU){
+	float u = nearU;
+	if(abs(point.x) > 1e-6f || abs(point.z) > 1e-6f){		// u is undefined on the poles
+		u = atan2(point.z, point.x)/(2.f*PI_F);
+		u -= floor(u - nearU + 0.5f);
+	}
+	return vec2(u, 1.f - acos(clamp(point.y, -1.f, 1.f))/PI_F);
+}
+
+//Index of vertex k along edge e of the grid, the edges run counterclockwise
+static int EdgeVertex(int e, int k){
+	const int last = TERRAIN_CHUNK_GRID;
+	switch(e){
+		case 0:  return k;								// b = 0
+		case 1:  return k*CHUNK_SIDE + last;			// a = 1
+		case 2:  return last*CHUNK_SIDE + last - k;		// b = 1
+		default: return (last - k)*CHUNK_SIDE;			// a = 0
+	}
+}
+
+//Writes the CHUNK_VERTICES vertices of a chunk, runs on the workers
+static void FillChunk(uint64_t key, TerrainVertex *vertices){
+	int face = KeyFace(key);
+	int level = KeyLevel(key);
+	float size = 2.f/float(1 << level);
+	float a0 = -1.f + KeyX(key)*size;
+	float b0 = -1.f + KeyY(key)*size;
+	float centreU = SphereTexCoord(ChunkCentre(key), 0.f).x;
+
+	for(int j = 0; j < CHUNK_SIDE; j++){
+		for(int i = 0; i < CHUNK_SIDE; i++){
+			vec3 point = FacePoint(face, a0 + size*i/TERRAIN_CHUNK_GRID, b0 + size*j/TERRAIN_CHUNK_GRID);
+			vertices[j*CHUNK_SIDE + i].position = point;
+			vertices[j*CHUNK_SIDE + i].texCoord = SphereTexCoord(point, centreU);
+		}
+	}
+
+	// skirts hang below the edges and hide the cracks where a neighbour is
+	// drawn at another level, deep enough to cover the sag of a coarse edge
+	float skirt = 1.f - 0.1f*ChunkArc(level);
+	for(int e = 0; e < 4; e++){
+		for(int k = 0; k < CHUNK_SIDE; k++){
+			const TerrainVertex& top = vertices[EdgeVertex(e, k)];
+			TerrainVertex& bottom = vertices[CHUNK_SIDE*CHUNK_SIDE + e*CHUNK_SIDE + k];
+			bottom.position = skirt*top.position;
+			bottom.texCoord = top.texCoord;
+		}
+	}
+}
+
+//Triangles of a chunk, the same for all of them
+static vector<GLuint> ChunkIndices(){
+	vector<GLuint> indices;
+	indices.reserve(CHUNK_INDICES);
+	for(int j = 0; j < TERRAIN_CHUNK_GRID; j++){
+		for(int i = 0; i < TERRAIN_CHUNK_GRID; i++){
+			GLuint corner = j*CHUNK_SIDE + i;
+			GLuint quad[6] = {corner, corner + 1, corner + CHUNK_SIDE + 1,
+							  corner, corner + CHUNK_SIDE + 1, corner + CHUNK_SIDE};
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+	for(int e = 0; e < 4; e++){
+		for(int k = 0; k < TERRAIN_CHUNK_GRID; k++){
+			GLuint top0 = EdgeVertex(e, k), top1 = EdgeVertex(e, k + 1);
+			GLuint bottom0 = CHUNK_SIDE*CHUNK_SIDE + e*CHUNK_SIDE + k, bottom1 = bottom0 + 1;
+			GLuint quad[6] = {top0, bottom0, bottom1, top0, bottom1, top1};
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+	return indices;
+}
+
+// --------------------------------------------------------------------------
+// Workers
+
+static void TerrainWorker(Terrain *terrain){
+	unique_lock<mutex> lock(terrain->mutex);
+	while(true){
+		terrain->wake.wait(lock, [terrain]{ return terrain->quit || !terrain->jobs.empty(); });
+		if(terrain->quit) return;
+		pair<int, uint64_t> job = terrain->jobs.front();
+		terrain->jobs.pop_front();
+		lock.unlock();
+
+		TerrainResult result;
+		result.slot = job.first;
+		result.vertices.resize(CHUNK_VERTICES);
+		FillChunk(job.second, result.vertices.data());
+
+		lock.lock();
+		terrain->results.push_back(std::move(result));
+	}
+}
+
+// --------------------------------------------------------------------------
+// Chunk pool
+
+//Puts a chunk in the pool and queues it, reusing an empty slot or else the
+//least recently used chunk not needed this frame. Root chunks are never
+//evicted, so every part of the sphere always has a chunk to draw.
+// Returns the slot, or -1 if the pool is full
+static int RequestChunk(Terrain *terrain, uint64_t key){
+	unordered_map<uint64_t, int>::const_iterator it = terrain->cache.find(key);
+	if(it != terrain->cache.end()) return it->second;
+
+	int slot = -1;
+	for(int s = 0; s < int(terrain->slots.size()); s++){
+		const TerrainSlot& candidate = terrain->slots[s];
+		if(candidate.state == TERRAIN_SLOT_EMPTY){
+			slot = s;
+			break;
+		}
+		if(candidate.state == TERRAIN_SLOT_READY && candidate.lastUsed != terrain->frame && KeyLevel(candidate.key) > ROOT_LEVEL
+			&& (slot < 0 || candidate.lastUsed < terrain->slots[slot].lastUsed))
+			slot = s;
+	}
+	if(slot < 0) return -1;
+
+	TerrainSlot& chosen = terrain->slots[slot];
+	if(chosen.state == TERRAIN_SLOT_READY)
+		terrain->cache.erase(chosen.key);
+	chosen.key = key;
+	chosen.state = TERRAIN_SLOT_PENDING;
+	chosen.lastUsed = terrain->frame;
+	terrain->cache[key] = slot;
+
+	{
+		lock_guard<mutex> lock(terrain->mutex);
+		terrain->jobs.push_back(make_pair(slot, key));
+	}
+	terrain->wake.notify_one();
+	return slot;
+}
+
+//Key of root chunk r, a quarter of face r/4
+static uint64_t RootKey(int r){
+	return ChunkKey(r/4, ROOT_LEVEL, r%2, (r/2)%2);
+}
+
+//Chunks entirely past the horizon seen from camera are hidden by the sphere
+static bool BeyondHorizon(uint64_t key, vec3 centre, vec3 camera){
+	float distance = length(camera);
+	if(distance <= 1.f) return false;
+	float angle = acos(clamp(dot(centre, camera)/distance, -1.f, 1.f));
+	// the chunk corners are up to ~0.7 of a side away from its centre
+	return angle > acos(1.f/distance) + 0.75f*ChunkArc(KeyLevel(key));
+}
+
+//Marks a ready chunk used and either draws it or descends into its children
+//when the camera is close and all 4 are ready. Children that are missing are
+//added to missing, to be requested once every used chunk is marked.
+static void SelectChunk(Terrain *terrain, uint64_t key, vec3 camera, vector<uint64_t>& missing){
+	int slot = terrain->cache[key];
+	terrain->slots[slot].lastUsed = terrain->frame;
+
+	vec3 centre = ChunkCentre(key);
+	if(BeyondHorizon(key, centre, camera)) return;
+
+	int level = KeyLevel(key);
+	if(level < TERRAIN_MAX_LEVEL && distance(camera, centre) < TERRAIN_SPLIT_DISTANCE*ChunkArc(level)){
+		uint64_t children[4];
+		bool ready = true;
+		for(int c = 0; c < 4; c++){
+			children[c] = ChunkKey(KeyFace(key), level + 1, 2*KeyX(key) + c%2, 2*KeyY(key) + c/2);
+			unordered_map<uint64_t, int>::const_iterator it = terrain->cache.find(children[c]);
+			if(it == terrain->cache.end()){
+				missing.push_back(children[c]);
+				ready = false;
+			}
+			else{
+				terrain->slots[it->second].lastUsed = terrain->frame;
+				ready = ready && terrain->slots[it->second].state == TERRAIN_SLOT_READY;
+			}
+		}
+		if(ready){
+			for(int c = 0; c < 4; c++)
+				SelectChunk(terrain, children[c], camera, missing);
+			return;
+		}
+	}
+
+	// the parent stands in until all its children are ready
+	terrain->drawCounts.push_back(CHUNK_INDICES);
+	terrain->drawOffsets.push_back(0);
+	terrain->drawBaseVertices.push_back(slot*CHUNK_VERTICES);
+}
+
+// --------------------------------------------------------------------------
+// Terrain
+
+bool InitializeTerrain(Terrain *terrain, int workerCount){
+	if(!InitializeVAO(&terrain->geometry)) return false;
+
+	Geometry& geometry = terrain->geometry;
+	geometry.elementCount = TERRAIN_POOL_CHUNKS*CHUNK_VERTICES;
+	geometry.indexCount = CHUNK_INDICES;
+	VertexAttribute position = {3, GL_FLOAT, sizeof(TerrainVertex), offsetof(TerrainVertex, position)};
+	VertexAttribute texCoord = {2, GL_FLOAT, sizeof(TerrainVertex), offsetof(TerrainVertex, texCoord)};
+	VertexAttribute none = {0, GL_FLOAT, 0, 0};
+	geometry.format.position = position;
+	geometry.format.texCoord = texCoord;
+	geometry.format.normal = none;
+
+	// the pool is filled a slot at a time as chunks finish
+	vector<GLuint> indices = ChunkIndices();
+	glBindVertexArray(geometry.vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, geometry.vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(TerrainVertex)*geometry.elementCount, 0, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*indices.size(), indices.data(), GL_STATIC_DRAW);
+	BindVertexFormat(&geometry);
+	glBindVertexArray(0);
+
+	TerrainSlot empty = {0, TERRAIN_SLOT_EMPTY, 0};
+	terrain->slots.assign(TERRAIN_POOL_CHUNKS, empty);
+
+	if(workerCount <= 0)
+		workerCount = std::max(1, int(thread::hardware_concurrency()) - 1);
+	for(int w = 0; w < workerCount; w++)
+		terrain->workers.push_back(thread(TerrainWorker, terrain));
+
+	for(int r = 0; r < ROOT_CHUNKS; r++)
+		RequestChunk(terrain, RootKey(r));
+
+	return !CheckGLErrors();
+}
+
+bool UpdateTerrain(Terrain *terrain, const mat4& modelMatrix, vec3 cameraPosition){
+	terrain->frame++;
+
+	// copy finished chunks into their slots
+	vector<TerrainResult> finished;
+	{
+		lock_guard<mutex> lock(terrain->mutex);
+		int count = std::min(int(terrain->results.size()), TERRAIN_UPLOADS_PER_FRAME);
+		for(int r = 0; r < count; r++)
+			finished.push_back(std::move(terrain->results[r]));
+		terrain->results.erase(terrain->results.begin(), terrain->results.begin() + count);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, terrain->geometry.vertexBuffer);
+	for(size_t r = 0; r < finished.size(); r++){
+		glBufferSubData(GL_ARRAY_BUFFER, sizeof(TerrainVertex)*CHUNK_VERTICES*finished[r].slot,
+						sizeof(TerrainVertex)*CHUNK_VERTICES, finished[r].vertices.data());
+		terrain->slots[finished[r].slot].state = TERRAIN_SLOT_READY;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	terrain->drawCounts.clear();
+	terrain->drawOffsets.clear();
+	terrain->drawBaseVertices.clear();
+	for(int r = 0; r < ROOT_CHUNKS; r++){
+		if(terrain->slots[terrain->cache[RootKey(r)]].state != TERRAIN_SLOT_READY)
+			return false;
+	}
+
+	vec3 camera = vec3(inverse(modelMatrix)*vec4(cameraPosition, 1.f));
+	vector<uint64_t> missing;
+	for(int r = 0; r < ROOT_CHUNKS; r++)
+		SelectChunk(terrain, RootKey(r), camera, missing);
+	for(size_t m = 0; m < missing.size(); m++)
+		RequestChunk(terrain, missing[m]);
+
+	return true;
+}
+
+void DrawTerrain(const Terrain *terrain, GLenum rendermode){
+	if(terrain->drawCounts.empty()) return;
+
+	glMultiDrawElementsBaseVertex(rendermode, terrain->drawCounts.data(), GL_UNSIGNED_INT,
+								  terrain->drawOffsets.data(), GLsizei(terrain->drawCounts.size()), terrain->drawBaseVertices.data());
+
+	frameStats.drawCalls++;
+	frameStats.triangles += long(terrain->drawCounts.size())*CHUNK_INDICES/3;
+}
+
+void DestroyTerrain(Terrain *terrain){
+	{
+		lock_guard<mutex> lock(terrain->mutex);
+		terrain->quit = true;
+	}
+	terrain->wake.notify_all();
+	for(size_t w = 0; w < terrain->workers.size(); w++)
+		terrain->workers[w].join();
+	terrain->workers.clear();
+
+	DestroyGeometry(&terrain->geometry);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "geometry.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------------------------
+// Chunked quadtree terrain for close-up views of a planet
+//	The unit sphere is split like a cube sphere into 6 faces, each quarter of a
+//	face is the root of a quadtree of square chunks. Every frame the chunks
+//	near the camera are split into their 4 children and the far ones merged
+//	back into their parent.
+//	Chunks are generated on worker threads and uploaded into a fixed pool of
+//	slots in one vertex buffer, the least recently used one is evicted when the
+//	pool is full. All chunks share one index buffer and are drawn with a single
+//	multi-draw call, so triangles and memory stay bounded at any distance.
+
+#define TERRAIN_CHUNK_GRID 16			//Quads along the side of a chunk
+#define TERRAIN_MAX_LEVEL 12			//Deepest quadtree level, level 0 would be a whole cube face
+#define TERRAIN_POOL_CHUNKS 512			//Chunks kept on the GPU
+#define TERRAIN_SPLIT_DISTANCE 2.f		//A chunk splits once the camera is closer than this many chunk sizes
+#define TERRAIN_UPLOADS_PER_FRAME 32	//Finished chunks copied to the GPU per frame
+#define TERRAIN_MIN_ALTITUDE 0.02f		//Closest the camera gets to the surface, in planet radii
+
+//Vertex of a chunk, positions on the unit sphere
+struct TerrainVertex
+{
+	glm::vec3 position;
+	glm::vec2 texCoord;
+};
+
+//Slot of the chunk pool
+struct TerrainSlot
+{
+	uint64_t key;			//Chunk held by the slot, see ChunkKey in terrain.cpp
+	int      state;			//TERRAIN_SLOT_ values
+	unsigned lastUsed;		//Frame the chunk was last drawn or had a child drawn
+};
+
+#define TERRAIN_SLOT_EMPTY 0
+#define TERRAIN_SLOT_PENDING 1		//Queued or being generated on a worker
+#define TERRAIN_SLOT_READY 2		//Uploaded, can be drawn
+
+//Chunk finished by a worker, waiting to be uploaded by the main thread
+struct TerrainResult
+{
+	int slot;
+	std::vector<TerrainVertex> vertices;
+};
+
+struct Terrain
+{
+	Geometry geometry;				//Pool vertex buffer and the shared index buffer
+	std::vector<TerrainSlot> slots;
+	std::unordered_map<uint64_t, int> cache;	//Chunk key to slot
+
+	// chunks picked by the last UpdateTerrain
+	std::vector<GLsizei> drawCounts;
+	std::vector<const GLvoid*> drawOffsets;
+	std::vector<GLint> drawBaseVertices;
+	unsigned frame;
+
+	// worker threads, everything below is guarded by mutex
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<std::pair<int, uint64_t> > jobs;	//Slot and chunk to generate
+	std::vector<TerrainResult> results;
+	bool quit;
+
+	Terrain();
+};
+
+//Creates the pool buffers, starts the workers and queues the 24 root chunks
+// ARGS:
+//	workerCount - threads generating chunks, 0 picks one less than the number of cores
+bool InitializeTerrain(Terrain *terrain, int workerCount = 0);
+
+//Uploads finished chunks, then picks the chunks to draw for a camera and
+//queues the missing ones. Returns false while the root chunks are still being
+//generated, nothing can be drawn yet.
+// ARGS:
+//	modelMatrix - places the unit sphere in the world, uniformly scaled
+//	cameraPosition - in world space
+bool UpdateTerrain(Terrain *terrain, const glm::mat4& modelMatrix, glm::vec3 cameraPosition);
+
+//Draws the chunks picked by the last UpdateTerrain with one multi-draw call,
+//the vertex array of the terrain geometry must be bound
+void DrawTerrain(const Terrain *terrain, GLenum rendermode);
+
+//Stops the workers and deletes the buffers
+void DestroyTerrain(Terrain *terrain);
@@ -2,7 +2,11 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
@@ -35,7 +39,7 @@ MyTexture::MyTexture() : textureID(0), target(0), width(0), height(0)
 	{}
 
 
-bool InitializeTexture(MyTexture* texture, const char* filename, GLenum target)
+bool InitializeTexture(MyTexture* texture, const char* filename, GLenum target, GLenum wrapS)
 {
 	int numComponents;
 	stbi_set_flip_vertically_on_load(true);
@@ -74,7 +78,7 @@ bool InitializeTexture(MyTexture* texture, const char* filename, GLenum target)
 		//Modifies behaviour for bound texture
 		// Note: Only wrapping modes supported for GL_TEXTURE_RECTANGLE when defining
 		// GL_TEXTURE_WRAP are GL_CLAMP_TO_EDGE or GL_CLAMP_TO_BORDER
-		glTexParameteri(texture->target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(texture->target, GL_TEXTURE_WRAP_S, wrapS);
 		glTexParameteri(texture->target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		glTexParameteri(texture->target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(texture->target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -90,6 +94,152 @@ bool InitializeTexture(MyTexture* texture, const char* filename, GLenum target)
 	return true; //error
 }
 
+bool InitializeTextureArray(MyTexture* texture, const char* const* filenames, int layerCount, int width, int height)
+{
+	texture->target = GL_TEXTURE_2D_ARRAY;
+	texture->width = width;
+	texture->height = height;
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);		//Set alignment to be 1
+	glGenTextures(1, &texture->textureID);
+	glBindTexture(texture->target, texture->textureID);
+	glTexImage3D(texture->target, 0, GL_RGB8, width, height, layerCount, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+
+	bool loaded = true;
+	stbi_set_flip_vertically_on_load(true);
+	vector<unsigned char> resized;
+	for(int layer = 0; layer < layerCount; layer++)
+	{
+		int w, h, numComponents;
+		unsigned char *data = stbi_load(filenames[layer], &w, &h, &numComponents, 3);
+		if (data == nullptr)
+		{
+			cout << "Could not load texture layer " << filenames[layer] << endl;
+			loaded = false;
+			continue;
+		}
+
+		unsigned char *pixels = data;
+		if (w != width || h != height)
+		{
+			resized.resize(width*height*3);
+			for(int y = 0; y < height; y++)
+			{
+				const unsigned char *row = data + (y*h/height)*w*3;
+				for(int x = 0; x < width; x++)
+				{
+					const unsigned char *texel = row + (x*w/width)*3;
+					unsigned char *out = &resized[(y*width + x)*3];
+					out[0] = texel[0]; out[1] = texel[1]; out[2] = texel[2];
+				}
+			}
+			pixels = resized.data();
+		}
+		glTexSubImage3D(texture->target, 0, 0, 0, layer, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+		stbi_image_free(data);
+	}
+
+	glTexParameteri(texture->target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(texture->target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(texture->target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(texture->target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Clean up
+	glBindTexture(texture->target, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);	//Return to default alignment
+
+	return !CheckGLErrors("Loading texture array: ") && loaded;
+}
+
+//Bilinear sample of an RGB equirectangular image in the direction (x, y, z)
+static void SampleEquirect(const unsigned char *image, int w, int h, float x, float y, float z, unsigned char *out)
+{
+	const float PI = 3.14159265359f;
+	float u = atan2(z, x) / (2*PI);
+	if (u < 0) u += 1;
+	float v = acos(fmax(-1.f, fmin(1.f, y / sqrt(x*x + y*y + z*z)))) / PI;	//0 at the top row
+
+	float fx = u*w - 0.5f, fy = v*h - 0.5f;
+	int x0 = int(floor(fx)), y0 = int(floor(fy));
+	float tx = fx - x0, ty = fy - y0;
+	int xs[2] = {(x0 % w + w) % w, ((x0 + 1) % w + w) % w};		//Wraps around in longitude
+	int ys[2] = {max(y0, 0), min(y0 + 1, h - 1)};
+	for (int c = 0; c < 3; c++)
+	{
+		float top = image[(ys[0]*w + xs[0])*3 + c]*(1 - tx) + image[(ys[0]*w + xs[1])*3 + c]*tx;
+		float bottom = image[(ys[1]*w + xs[0])*3 + c]*(1 - tx) + image[(ys[1]*w + xs[1])*3 + c]*tx;
+		out[c] = (unsigned char)(top*(1 - ty) + bottom*ty + 0.5f);
+	}
+}
+
+bool InitializeCubeMap(MyTexture* texture, const char* filename, int faceSize)
+{
+	int w, h, numComponents;
+	stbi_set_flip_vertically_on_load(false);
+	unsigned char *data = stbi_load(filename, &w, &h, &numComponents, 3);
+	if (data == nullptr)
+	{
+		cout << "Could not load cube map " << filename << endl;
+		return false;
+	}
+
+	// every face on its own thread, s and t run over [-1, 1] as in the
+	// cube map face selection of the GL specification
+	vector<unsigned char> faces[6];
+	vector<thread> workers;
+	for (int face = 0; face < 6; face++)
+	{
+		faces[face].resize(faceSize*faceSize*3);
+		workers.push_back(thread([&, face]() {
+			for (int row = 0; row < faceSize; row++)
+			{
+				float t = 2*(row + 0.5f)/faceSize - 1;
+				for (int col = 0; col < faceSize; col++)
+				{
+					float s = 2*(col + 0.5f)/faceSize - 1;
+					float x, y, z;
+					switch (face)
+					{
+						case 0: x = 1;  y = -t; z = -s; break;	//+x
+						case 1: x = -1; y = -t; z = s;  break;	//-x
+						case 2: x = s;  y = 1;  z = t;  break;	//+y
+						case 3: x = s;  y = -1; z = -t; break;	//-y
+						case 4: x = s;  y = -t; z = 1;  break;	//+z
+						default: x = -s; y = -t; z = -1; break;	//-z
+					}
+					SampleEquirect(data, w, h, x, y, z, &faces[face][(row*faceSize + col)*3]);
+				}
+			}
+		}));
+	}
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+	stbi_image_free(data);
+
+	texture->target = GL_TEXTURE_CUBE_MAP;
+	texture->width = faceSize;
+	texture->height = faceSize;
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);		//Set alignment to be 1
+	glGenTextures(1, &texture->textureID);
+	glBindTexture(texture->target, texture->textureID);
+	for (int face = 0; face < 6; face++)
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB8, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, faces[face].data());
+	glGenerateMipmap(texture->target);
+
+	glTexParameteri(texture->target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(texture->target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(texture->target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(texture->target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(texture->target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Clean up
+	glBindTexture(texture->target, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);	//Return to default alignment
+
+	return !CheckGLErrors( (string("Loading cube map: ")+filename).c_str() );
+}
+
 // deallocate texture-related objects
 void DestroyTexture(MyTexture *texture)
 {
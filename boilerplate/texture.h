@@ -27,7 +27,29 @@ struct MyTexture
 //	texture - Properties of created texture is returned here
 //	filename - Name of image file to create texture from
 //	target - Type of texture generated, eg GL_TEXTURE_2D and GL_TEXTURE_RECTANGLE
-bool InitializeTexture(MyTexture* texture, const char* filename, GLenum target = GL_TEXTURE_2D);
+//	wrapS - Wrapping along s, GL_REPEAT for textures wrapped around a sphere
+bool InitializeTexture(MyTexture* texture, const char* filename, GLenum target = GL_TEXTURE_2D, GLenum wrapS = GL_CLAMP_TO_EDGE);
+
+//Function to create a 2D texture array with one layer per image file
+//	All images are stored as RGB, an image whose size differs from the
+//	layer size is resampled (nearest neighbour) to fit. The layers repeat
+//	along s since they are wrapped around spheres
+// ARGS:
+//	texture - Properties of created texture is returned here, target is GL_TEXTURE_2D_ARRAY
+//	filenames - Name of the image file for each layer
+//	layerCount - Number of layers
+//	width, height - Size of every layer
+bool InitializeTextureArray(MyTexture* texture, const char* const* filenames, int layerCount, int width, int height);
+
+//Function to create a mip-mapped cube map from an equirectangular image,
+//the panorama is resampled into the 6 faces once at load
+//	Directions map to the image as on the planet spheres: u follows the
+//	longitude atan(z, x), the top row is the +y pole
+// ARGS:
+//	texture - Properties of created texture is returned here, target is GL_TEXTURE_CUBE_MAP
+//	filename - Name of the equirectangular image file
+//	faceSize - Width and height of every face
+bool InitializeCubeMap(MyTexture* texture, const char* filename, int faceSize);
 
 // deallocate texture-related objects
 void DestroyTexture(MyTexture *texture);
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "uniformblocks.h"
+#include <cstring>
+
+using namespace glm;
+
+bool CheckGLErrors();
+
+UniformBlocks::UniformBlocks() : stream(0), alignment(1), objectStride(0), objectCapacity(0), objectOffset(-1)
+	{}
+
+bool InitializeUniformBlocks(UniformBlocks *blocks, StreamBuffer *stream, int objectCapacity){
+	// every bound range must start at a multiple of the offset alignment
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &blocks->alignment);
+	blocks->stream = stream;
+	blocks->objectStride = (sizeof(ObjectUniforms) + blocks->alignment - 1)/blocks->alignment*blocks->alignment;
+	blocks->objectCapacity = objectCapacity;
+	blocks->objects.assign(blocks->objectStride*objectCapacity, 0);
+
+	return !CheckGLErrors();
+}
+
+void UpdateFrameBlock(UniformBlocks *blocks, const mat4& viewProjection, vec3 camPosition, float time){
+	FrameUniforms frame = {viewProjection, camPosition, time};
+
+	GLintptr offset = StreamWrite(blocks->stream, &frame, sizeof(frame), blocks->alignment);
+	if(offset >= 0)
+		glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, blocks->stream->buffer, offset, sizeof(FrameUniforms));
+}
+
+void UpdateObjectBlocks(UniformBlocks *blocks, const mat4 *modelMatrices, int count){
+	if(count > blocks->objectCapacity) count = blocks->objectCapacity;
+	for(int i = 0; i < count; i++){
+		ObjectUniforms object = {modelMatrices[i]};
+		memcpy(&blocks->objects[blocks->objectStride*i], &object, sizeof(object));
+	}
+
+	blocks->objectOffset = StreamWrite(blocks->stream, blocks->objects.data(), blocks->objectStride*count, blocks->alignment);
+}
+
+void BindObjectBlock(const UniformBlocks *blocks, int object){
+	if(blocks->objectOffset < 0) return;
+	glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, blocks->stream->buffer,
+					  blocks->objectOffset + blocks->objectStride*object, sizeof(ObjectUniforms));
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "streambuffer.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// --------------------------------------------------------------------------
+// Uniform buffers shared by every program
+//	FrameBlock holds what is the same for every draw of a frame and is
+//	written once per frame. ObjectBlock holds the model matrix of one object,
+//	all objects of a frame are written together and each draw only binds the
+//	range of its object. Both live in the streaming buffer. The std140 layouts
+//	below match the blocks declared in the shaders.
+
+#define FRAME_BLOCK_BINDING 0
+#define OBJECT_BLOCK_BINDING 1
+
+struct FrameUniforms
+{
+	glm::mat4 viewProjection;
+	glm::vec3 camPosition;
+	float     time;				//Seconds since startup, packs after camPosition in std140
+};
+
+struct ObjectUniforms
+{
+	glm::mat4 modelMatrix;
+};
+
+struct UniformBlocks
+{
+	StreamBuffer *stream;
+	GLint    alignment;			//GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	GLint    objectStride;		//sizeof(ObjectUniforms) rounded up to the offset alignment
+	int      objectCapacity;
+	GLintptr objectOffset;		//Where this frame's objects are in the stream, -1 if nowhere
+	std::vector<char> objects;	//Objects padded to the stride, written to the stream in one go
+
+	UniformBlocks();
+};
+
+//Sets up room for objectCapacity objects per frame in the stream
+bool InitializeUniformBlocks(UniformBlocks *blocks, StreamBuffer *stream, int objectCapacity);
+
+//Writes the frame block to the stream and binds it to FRAME_BLOCK_BINDING
+void UpdateFrameBlock(UniformBlocks *blocks, const glm::mat4& viewProjection, glm::vec3 camPosition, float time);
+
+//Writes the model matrices of the objects of a frame to the stream, object i
+//is then selected with BindObjectBlock(blocks, i). At most objectCapacity are
+//kept
+void UpdateObjectBlocks(UniformBlocks *blocks, const glm::mat4 *modelMatrices, int count);
+
+//Binds the range of one object to OBJECT_BLOCK_BINDING
+void BindObjectBlock(const UniformBlocks *blocks, int object);
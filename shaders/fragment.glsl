@@ -6,12 +6,19 @@
 // ==========================================================================
 #version 410
 
+// the program is compiled once per material variant, LoadSource adds
+//  SHADED - lit by the sun, otherwise emissive
+//  NIGHT  - night side texture and ocean highlights from the specular map
+
 // interpolated colour received from vertex stage
 uniform sampler2D image;
 uniform sampler2D nightmap;
-uniform int shade_flg;
-uniform int night_flg;
-uniform vec3 camPosition;
+// per frame uniform block, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
 uniform sampler2D pecularmap;
 
 in vec2 Texcoord;   
@@ -30,28 +37,27 @@ float dot_normal(vec3 a, vec3 b){
 }
 void main(void)
 {
-    if(shade_flg == 1){
-        vec3 n = normalize(Vertexp - center);
-        vec3 l = normalize(vec3(0,0,0) - Vertexp);
-        float diffuse;
-        diffuse = max(dot_normal(n, l), 0);
-        float ratio = min(1, 0.2 + diffuse);
-        
-        if(night_flg == 1){
-            vec4 spec = texture(pecularmap, Texcoord);
-            if(spec.x == 0 && spec.y == 0 && spec.z == 0){
-                FragmentColour = texture(image, Texcoord) * ratio + texture(nightmap, Texcoord) * (1 - ratio);
-            }
-            else{   // ocean
-                vec3 viewDir = normalize(camPosition - Vertexp);   // View ray
-                vec3 reflect_light = -l + 2 * n * (dot_normal(n,l));
-
-                float spec_ratio = 0.7 * max(0,dot_normal(reflect_light, viewDir));
-                FragmentColour = texture(image, Texcoord) * ratio + diffuse * pow(spec_ratio ,2) + texture(nightmap, Texcoord) * (1 - ratio);
-            }
-        }
-        else FragmentColour = texture(image, Texcoord) * ratio;
-    }else{
-        FragmentColour = texture(image, Texcoord);
-    }
+#ifdef SHADED
+    vec3 n = normalize(Vertexp - center);
+    vec3 l = normalize(vec3(0,0,0) - Vertexp);
+    float diffuse;
+    diffuse = max(dot_normal(n, l), 0);
+    float ratio = min(1, 0.2 + diffuse);
+    FragmentColour = texture(image, Texcoord) * ratio;
+
+#ifdef NIGHT
+    FragmentColour += texture(nightmap, Texcoord) * (1 - ratio);
+
+    // the specular map is black on land, which masks the highlight off
+    vec4 spec = texture(pecularmap, Texcoord);
+    float ocean = float(any(greaterThan(spec.rgb, vec3(0))));
+    vec3 viewDir = normalize(camPosition - Vertexp);   // View ray
+    vec3 reflect_light = -l + 2 * n * (dot_normal(n,l));
+
+    float spec_ratio = 0.7 * max(0,dot_normal(reflect_light, viewDir));
+    FragmentColour += ocean * diffuse * pow(spec_ratio ,2);
+#endif
+#else
+    FragmentColour = texture(image, Texcoord);
+#endif
 }
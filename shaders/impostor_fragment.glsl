@@ -0,0 +1,80 @@
+// ==========================================================================
+// Fragment program for sphere impostors
+//
+// Intersects the view ray with the sphere, fragments that miss it are
+// discarded. The hit point gives the depth, the normal and planetMaker's
+// texture coordinates, then the body is shaded as in fragment.glsl.
+// ==========================================================================
+#version 410
+
+uniform sampler2D image;
+uniform sampler2D nightmap;
+uniform sampler2D pecularmap;
+// per frame uniform block, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+
+in vec3 Vertexp;    // point on the quad
+in vec3 center;     // planet center
+flat in float radius;
+flat in mat3 objectFromWorld;
+
+// first output is mapped to the framebuffer's colour index by default
+out vec4 FragmentColour;
+
+const float PI = 3.14159265359;
+
+void main(void)
+{
+    // nearest intersection of the ray camPosition + s*dir with the sphere
+    vec3 dir = normalize(Vertexp - camPosition);
+    vec3 oc = camPosition - center;
+    float b = dot(oc, dir);
+    float h = b*b - (dot(oc, oc) - radius*radius);
+    if(h < 0) discard;
+    vec3 hit = camPosition + (-b - sqrt(h)) * dir;
+
+    vec4 clip = viewProjection * vec4(hit, 1.0);
+    gl_FragDepth = 0.5 * clip.z / clip.w + 0.5;
+
+    // planetMaker's mapping: u follows the longitude, v = 1 at the north pole
+    vec3 q = normalize(objectFromWorld * (hit - center));
+    float u = atan(q.z, q.x) / (2*PI);
+    vec2 Texcoord = vec2(u < 0 ? u + 1 : u, 1 - acos(clamp(q.y, -1, 1)) / PI);
+
+    // u wraps from 1 to 0 on the prime meridian, where its implicit
+    // derivatives would select the smallest mip level and draw a seam. The
+    // atan result in [-0.5, 0.5] wraps on the opposite meridian instead, so
+    // the derivative of smaller magnitude of the two is the continuous one
+    vec2 dx = vec2(dFdx(Texcoord.x), dFdx(Texcoord.y));
+    vec2 dy = vec2(dFdy(Texcoord.x), dFdy(Texcoord.y));
+    float dxu = dFdx(u), dyu = dFdy(u);
+    if(abs(dxu) < abs(dx.x)) dx.x = dxu;
+    if(abs(dyu) < abs(dy.x)) dy.x = dyu;
+
+#ifndef SHADED
+    FragmentColour = textureGrad(image, Texcoord, dx, dy);
+#else
+    vec3 n = normalize(hit - center);
+    vec3 l = normalize(vec3(0,0,0) - hit);
+    float diffuse = max(dot(n, l), 0);
+    float ratio = min(1, 0.2 + diffuse);
+    FragmentColour = textureGrad(image, Texcoord, dx, dy) * ratio;
+
+#ifdef NIGHT
+    FragmentColour += textureGrad(nightmap, Texcoord, dx, dy) * (1 - ratio);
+
+    // the specular map is black on land, which masks the highlight off
+    vec4 spec = textureGrad(pecularmap, Texcoord, dx, dy);
+    float ocean = float(any(greaterThan(spec.rgb, vec3(0))));
+    vec3 viewDir = normalize(camPosition - hit);   // View ray
+    vec3 reflect_light = -l + 2 * n * dot(n, l);
+
+    float spec_ratio = 0.7 * max(0, dot(reflect_light, viewDir));
+    FragmentColour += ocean * diffuse * pow(spec_ratio, 2);
+#endif
+#endif
+}
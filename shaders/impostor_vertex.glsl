@@ -0,0 +1,46 @@
+// ==========================================================================
+// Vertex program for sphere impostors
+//
+// Draws a body as a quad facing the camera, the fragment program ray-casts
+// the sphere inside it. The quad is built from gl_VertexID (6 vertices, two
+// triangles) so no vertex buffer is needed.
+// ==========================================================================
+#version 410
+
+// per frame and per object uniform blocks, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+layout(std140) uniform ObjectBlock {
+    mat4 modelMatrix;   // unit sphere to world, uniform scale
+};
+
+out vec3 Vertexp;   // point on the quad
+out vec3 center;    // planet center
+flat out float radius;
+flat out mat3 objectFromWorld;      // world direction to unit sphere direction
+
+const vec2 corners[6] = vec2[6](vec2(-1, -1), vec2(1, -1), vec2(1, 1),
+                                vec2(-1, -1), vec2(1, 1), vec2(-1, 1));
+
+void main()
+{
+    center = modelMatrix[3].xyz;
+    radius = length(modelMatrix[0].xyz);
+    objectFromWorld = inverse(mat3(modelMatrix));
+
+    vec3 forward = normalize(camPosition - center);
+    vec3 right = normalize(cross(abs(forward.y) < 0.99 ? vec3(0, 1, 0) : vec3(1, 0, 0), forward));
+    vec3 up = cross(forward, right);
+
+    // a quad through the centre covers the silhouette when it spans the
+    // tangent cone from the camera, d*r/sqrt(d^2 - r^2) at the centre
+    float d = length(camPosition - center);
+    float halfSize = radius * d / sqrt(max(d*d - radius*radius, 1e-12));
+
+    vec2 corner = corners[gl_VertexID];
+    Vertexp = center + halfSize * (corner.x * right + corner.y * up);
+    gl_Position = viewProjection * vec4(Vertexp, 1.0);
+}
@@ -0,0 +1,48 @@
+// ==========================================================================
+// Vertex program for multi-draw indirect planet rendering
+//
+// The whole scene is one glMultiDrawElementsIndirect, every draw reads its
+// model matrix and material from the storage buffer at its draw id. The
+// outputs match instanced_vertex.glsl, the fragment program is shared.
+// Written against 4.1 with the extensions, so it also builds on 4.1 and 4.2
+// contexts that have them. The storage block binding is set by
+// InitializeIndirectProgram().
+// ==========================================================================
+#version 410
+#extension GL_ARB_shader_storage_buffer_object : require
+#extension GL_ARB_shader_draw_parameters : require
+
+layout(location = 0) in vec3 VertexPosition;
+layout(location = 1) in vec2 TextureCoord;
+
+// per frame uniform block, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+
+// InstanceData of every draw, see indirect.h
+struct DrawData {
+    mat4 modelMatrix;
+    ivec4 material;
+};
+layout(std430) buffer DrawBlock {
+    DrawData draws[];
+};
+
+out vec2 Texcoord;
+out vec3 Vertexp;
+out vec3 center;
+flat out ivec4 material;
+
+void main()
+{
+    DrawData draw = draws[gl_DrawIDARB];
+    vec4 world = draw.modelMatrix * vec4(VertexPosition, 1.0);
+    center = draw.modelMatrix[3].xyz;
+    Vertexp = world.xyz;
+    gl_Position = viewProjection * world;
+    Texcoord = TextureCoord;
+    material = draw.material;
+}
@@ -0,0 +1,54 @@
+// ==========================================================================
+// Fragment program for instanced planet rendering
+//
+// material.x: day texture layer
+// material.y: night texture layer, -1 if none
+// material.z: specular map layer, -1 if none
+// material.w: 1 if lit by the sun
+// ==========================================================================
+#version 410
+
+uniform sampler2DArray layers;
+// per frame uniform block, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+
+in vec2 Texcoord;
+in vec3 Vertexp;    // vertex position
+in vec3 center;     // planet center
+flat in ivec4 material;
+
+// first output is mapped to the framebuffer's colour index by default
+out vec4 FragmentColour;
+
+void main(void)
+{
+    vec4 day = texture(layers, vec3(Texcoord, material.x));
+    if(material.w == 0){
+        FragmentColour = day;
+        return;
+    }
+
+    vec3 n = normalize(Vertexp - center);
+    vec3 l = normalize(vec3(0,0,0) - Vertexp);
+    float diffuse = max(dot(n, l), 0);
+    float ratio = min(1, 0.2 + diffuse);
+    FragmentColour = day * ratio;
+
+    if(material.y >= 0){
+        FragmentColour += texture(layers, vec3(Texcoord, material.y)) * (1 - ratio);
+    }
+    if(material.z >= 0){
+        vec4 spec = texture(layers, vec3(Texcoord, material.z));
+        if(spec.x != 0 || spec.y != 0 || spec.z != 0){   // ocean
+            vec3 viewDir = normalize(camPosition - Vertexp);   // View ray
+            vec3 reflect_light = -l + 2 * n * dot(n, l);
+
+            float spec_ratio = 0.7 * max(0, dot(reflect_light, viewDir));
+            FragmentColour += diffuse * pow(spec_ratio, 2);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+// ==========================================================================
+// Vertex program for instanced planet rendering
+//
+// Every instance carries its own model matrix and material, the mesh
+// attributes are shared by all instances.
+// ==========================================================================
+#version 410
+
+// location indices for these attributes correspond to those specified in the
+// InitializeInstanceBatch() function of the main program
+layout(location = 0) in vec3 VertexPosition;
+layout(location = 1) in vec2 TextureCoord;
+layout(location = 3) in mat4 InstanceModel;
+layout(location = 7) in ivec4 InstanceMaterial;
+
+// per frame uniform block, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+
+out vec2 Texcoord;
+out vec3 Vertexp;
+out vec3 center;
+flat out ivec4 material;
+
+void main()
+{
+    vec4 world = InstanceModel * vec4(VertexPosition, 1.0);
+    center = InstanceModel[3].xyz;
+    Vertexp = world.xyz;
+    gl_Position = viewProjection * world;
+    Texcoord = TextureCoord;
+    material = InstanceMaterial;
+}
@@ -0,0 +1,11 @@
+// ==========================================================================
+// Fragment program for the occlusion proxies
+//
+// Writes nothing, colour and depth writes are off while the proxies are
+// drawn and only the samples passing the depth test matter.
+// ==========================================================================
+#version 410
+
+void main(void)
+{
+}
@@ -0,0 +1,35 @@
+// ==========================================================================
+// Vertex program for the occlusion proxies
+//
+// Draws the cube around the unit sphere of an object, built from gl_VertexID
+// (36 vertices, 12 triangles). Only whether any of it passes the depth test
+// is counted, see occlusion.h.
+// ==========================================================================
+#version 410
+
+// per frame and per object uniform blocks, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+layout(std140) uniform ObjectBlock {
+    mat4 modelMatrix;   // unit sphere to world, uniform scale
+};
+
+// corner i has x, y, z of -1 or 1 from bits 0, 1, 2
+const int cubeCorners[36] = int[36](
+    0, 2, 1,  1, 2, 3,      // -z
+    4, 5, 6,  5, 7, 6,      // +z
+    0, 1, 4,  1, 5, 4,      // -y
+    2, 6, 3,  3, 6, 7,      // +y
+    0, 4, 2,  2, 4, 6,      // -x
+    1, 3, 5,  3, 7, 5       // +x
+);
+
+void main()
+{
+    int corner = cubeCorners[gl_VertexID];
+    vec3 position = vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) * 2.0 - 1.0;
+    gl_Position = viewProjection * modelMatrix * vec4(position, 1.0);
+}
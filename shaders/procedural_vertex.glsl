@@ -0,0 +1,57 @@
+// ==========================================================================
+// Vertex program for spheres drawn without vertex buffers
+//
+// Builds the same latitude/longitude sphere as planetMaker from gl_VertexID:
+// every quad of the grid is 6 vertices, two triangles. The quads touching a
+// pole have one triangle collapsed onto the pole, which is never rasterized.
+// Draw 12*segments*segments vertices with an empty vertex array object.
+// ==========================================================================
+#version 410
+
+// per frame and per object uniform blocks, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+layout(std140) uniform ObjectBlock {
+    mat4 modelMatrix;   // unit sphere to world, uniform scale
+};
+uniform int segments;   // number of rings, the sphere has 2*segments segments around
+
+out vec2 Texcoord;
+out vec3 Vertexp;
+out vec3 center;
+
+const float PI = 3.14159265359;
+
+// (ring, column) offset of every vertex of a quad, same winding as planetMaker
+const ivec2 corners[6] = ivec2[6](ivec2(0, 0), ivec2(1, 0), ivec2(1, 1),
+                                  ivec2(0, 0), ivec2(1, 1), ivec2(0, 1));
+
+void main()
+{
+    int quad = gl_VertexID / 6;
+    ivec2 corner = corners[gl_VertexID % 6];
+    int ring = quad / (2*segments) + corner.x;
+    int column = quad % (2*segments) + corner.y;
+
+    float t = ring * PI / segments;
+    float p = column * PI / segments;
+    vec3 position = vec3(sin(t)*cos(p), cos(t), sin(t)*sin(p));
+    Texcoord = vec2(0.5*column/segments, 1.0 - float(ring)/segments);
+
+    // pole vertices take the u of the middle of their triangle
+    if(ring == 0){
+        position = vec3(0, 1, 0);
+        Texcoord.x += 0.25/segments;
+    }
+    else if(ring == segments){
+        position = vec3(0, -1, 0);
+        Texcoord.x -= 0.25/segments;
+    }
+
+    center = (modelMatrix * vec4(0, 0, 0, 1)).xyz;
+    Vertexp = (modelMatrix * vec4(position, 1.0)).xyz;
+    gl_Position = viewProjection * vec4(Vertexp, 1.0);
+}
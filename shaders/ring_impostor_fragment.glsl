@@ -0,0 +1,31 @@
+// ==========================================================================
+// Fragment program for the ring impostor
+//
+// The rasterized square is the intersection of the view rays with the ring
+// plane, points outside the annulus are discarded. Texture coordinates
+// follow generateRing: u from 0.1 at the inner edge to 1 at the outer edge,
+// v from 0 to 1 across each of its segments.
+// ==========================================================================
+#version 410
+
+uniform sampler2D image;
+uniform vec2 ringRadii;     // inner and outer radius in model units
+
+in vec2 ringPoint;
+
+// first output is mapped to the framebuffer's colour index by default
+out vec4 FragmentColour;
+
+const float PI = 3.14159265359;
+const float SEGMENTS = 128.0;   // RING_SEGMENTS of generateRing
+
+void main(void)
+{
+    float r = length(ringPoint);
+    if(r < ringRadii.x || r > ringRadii.y) discard;
+
+    float angle = atan(ringPoint.y, ringPoint.x);
+    vec2 Texcoord = vec2(mix(0.1, 1.0, (r - ringRadii.x) / (ringRadii.y - ringRadii.x)),
+                         fract(angle / (2*PI) * SEGMENTS));
+    FragmentColour = texture(image, Texcoord);
+}
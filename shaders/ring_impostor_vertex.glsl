@@ -0,0 +1,30 @@
+// ==========================================================================
+// Vertex program for the ring impostor
+//
+// Draws a square in the ring plane (y = 0 of the model) just covering the
+// outer edge of the ring, the fragment program cuts the annulus out of it.
+// Built from gl_VertexID like impostor_vertex.glsl.
+// ==========================================================================
+#version 410
+
+// per frame and per object uniform blocks, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+layout(std140) uniform ObjectBlock {
+    mat4 modelMatrix;   // unit sphere to world, uniform scale
+};
+uniform vec2 ringRadii;             // inner and outer radius in model units
+
+out vec2 ringPoint;     // position in the ring plane, model units
+
+const vec2 corners[6] = vec2[6](vec2(-1, -1), vec2(1, -1), vec2(1, 1),
+                                vec2(-1, -1), vec2(1, 1), vec2(-1, 1));
+
+void main()
+{
+    ringPoint = ringRadii.y * corners[gl_VertexID];
+    gl_Position = viewProjection * modelMatrix * vec4(ringPoint.x, 0.0, ringPoint.y, 1.0);
+}
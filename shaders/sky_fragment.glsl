@@ -0,0 +1,18 @@
+// ==========================================================================
+// Fragment program for the star background
+//
+// Looks the view ray up in the sky cube map, see InitializeCubeMap.
+// ==========================================================================
+#version 410
+
+uniform samplerCube image;
+
+in vec3 viewRay;
+
+// first output is mapped to the framebuffer's colour index by default
+out vec4 FragmentColour;
+
+void main(void)
+{
+    FragmentColour = texture(image, viewRay);
+}
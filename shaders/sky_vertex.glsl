@@ -0,0 +1,30 @@
+// ==========================================================================
+// Vertex program for the star background
+//
+// One triangle covering the screen, built from gl_VertexID. Its corners lie
+// on the far plane, so the sky is drawn after the bodies and the depth test
+// rejects the covered fragments before they are shaded. The view ray of each
+// corner is recovered from the inverse view projection and interpolated.
+// ==========================================================================
+#version 410
+
+// per frame uniform block, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+
+out vec3 viewRay;   // world space direction, not normalized
+
+const vec2 corners[3] = vec2[3](vec2(-1, -1), vec2(3, -1), vec2(-1, 3));
+
+void main()
+{
+    vec2 corner = corners[gl_VertexID];
+    vec4 far = inverse(viewProjection) * vec4(corner, 1.0, 1.0);
+    viewRay = far.xyz / far.w - camPosition;
+    // z = w is depth 1 after the perspective divide, passing GL_LEQUAL only
+    // where nothing was drawn
+    gl_Position = vec4(corner, 1.0, 1.0);
+}
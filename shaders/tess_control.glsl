@@ -0,0 +1,68 @@
+// ==========================================================================
+// Tessellation control program for tessellated spheres
+//
+// Splits every edge of a patch so its pieces cover about edgePixels pixels
+// on screen. The level of an edge only depends on its two end points, so the
+// patches on both sides of it agree and no cracks open between them.
+// ==========================================================================
+#version 410
+
+layout(vertices = 3) out;
+
+// per frame and per object uniform blocks, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+layout(std140) uniform ObjectBlock {
+    mat4 modelMatrix;   // unit sphere to world, uniform scale
+};
+uniform float pixelScale;   // pixels covered by one unit at distance one
+uniform float edgePixels;   // target length of a tessellated edge in pixels
+
+in vec3 Position[];
+in vec2 Angles[];
+out vec3 PatchPosition[];
+out vec2 PatchAngles[];
+
+vec3 SpherePoint(vec3 position)
+{
+    return (modelMatrix * vec4(position, 1.0)).xyz;
+}
+
+float EdgeLevel(vec3 a, vec3 b)
+{
+    float pixels = length(a - b) * pixelScale / max(distance(0.5*(a + b), camPosition), 1e-4);
+    return clamp(pixels / edgePixels, 1.0, 64.0);
+}
+
+void main()
+{
+    PatchPosition[gl_InvocationID] = Position[gl_InvocationID];
+    PatchAngles[gl_InvocationID] = Angles[gl_InvocationID];
+
+    if(gl_InvocationID == 0){
+        vec3 p0 = SpherePoint(Position[0]);
+        vec3 p1 = SpherePoint(Position[1]);
+        vec3 p2 = SpherePoint(Position[2]);
+
+        // patches collapsed onto a pole have two corners on it
+        int poleCorners = 0;
+        for(int i = 0; i < 3; i++)
+            if(sin(Angles[i].x) < 1e-4) poleCorners++;
+        if(poleCorners > 1){
+            gl_TessLevelOuter[0] = 0.0;
+            gl_TessLevelOuter[1] = 0.0;
+            gl_TessLevelOuter[2] = 0.0;
+            gl_TessLevelInner[0] = 0.0;
+            return;
+        }
+
+        // outer level i is the edge facing corner i
+        gl_TessLevelOuter[0] = EdgeLevel(p1, p2);
+        gl_TessLevelOuter[1] = EdgeLevel(p2, p0);
+        gl_TessLevelOuter[2] = EdgeLevel(p0, p1);
+        gl_TessLevelInner[0] = max(gl_TessLevelOuter[0], max(gl_TessLevelOuter[1], gl_TessLevelOuter[2]));
+    }
+}
@@ -0,0 +1,43 @@
+// ==========================================================================
+// Tessellation evaluation program for tessellated spheres
+//
+// Interpolates the corner positions and puts every generated vertex back on
+// the unit sphere, so silhouettes stay round at any level. A vertex on an
+// edge only depends on the edge's end points, which patches sharing the edge
+// agree on, so no cracks open between them. The texture coordinates are
+// still interpolated from the corner angles, where each pole patch has its
+// own azimuth for the pole.
+// ==========================================================================
+#version 410
+
+layout(triangles, fractional_odd_spacing, ccw) in;
+
+// per frame and per object uniform blocks, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+layout(std140) uniform ObjectBlock {
+    mat4 modelMatrix;   // unit sphere to world, uniform scale
+};
+
+in vec3 PatchPosition[];
+in vec2 PatchAngles[];
+
+out vec2 Texcoord;
+out vec3 Vertexp;
+out vec3 center;
+
+const float PI = 3.14159265359;
+
+void main()
+{
+    vec3 position = normalize(gl_TessCoord.x*PatchPosition[0] + gl_TessCoord.y*PatchPosition[1] + gl_TessCoord.z*PatchPosition[2]);
+    vec2 angles = gl_TessCoord.x*PatchAngles[0] + gl_TessCoord.y*PatchAngles[1] + gl_TessCoord.z*PatchAngles[2];
+    Texcoord = vec2(angles.y / (2.0*PI), 1.0 - angles.x / PI);
+
+    center = (modelMatrix * vec4(0, 0, 0, 1)).xyz;
+    Vertexp = (modelMatrix * vec4(position, 1.0)).xyz;
+    gl_Position = viewProjection * vec4(Vertexp, 1.0);
+}
@@ -0,0 +1,45 @@
+// ==========================================================================
+// Vertex program for tessellated spheres
+//
+// Emits the corners of the same coarse latitude/longitude grid as the
+// procedural sphere program, as points on the unit sphere and as angles for
+// the texture coordinates. Every quad is two triangle patches,
+// the quads touching a pole have one patch collapsed onto the pole, which
+// the control program drops. Draw 12*segments*segments patch vertices with
+// an empty vertex array object and GL_PATCHES.
+// ==========================================================================
+#version 410
+
+uniform int segments;   // number of rings of the base grid
+
+out vec3 Position;      // corner on the unit sphere, shared by every patch meeting there
+out vec2 Angles;        // (polar angle, azimuth) for the texture coordinates
+
+const float PI = 3.14159265359;
+
+const ivec2 corners[6] = ivec2[6](ivec2(0, 0), ivec2(1, 0), ivec2(1, 1),
+                                  ivec2(0, 0), ivec2(1, 1), ivec2(0, 1));
+
+void main()
+{
+    int quad = gl_VertexID / 6;
+    ivec2 corner = corners[gl_VertexID % 6];
+    int ring = quad / (2*segments) + corner.x;
+    int column = quad % (2*segments) + corner.y;
+
+    // the seam column and the poles are placed exactly, so patches reaching
+    // them from either side get the same corner
+    vec2 corner_angles = vec2(ring, column % (2*segments)) * PI / segments;
+    Position = vec3(sin(corner_angles.x)*cos(corner_angles.y), cos(corner_angles.x),
+                    sin(corner_angles.x)*sin(corner_angles.y));
+    if(ring == 0) Position = vec3(0, 1, 0);
+    else if(ring == segments) Position = vec3(0, -1, 0);
+
+    // pole vertices take the azimuth of the middle of their patch, which only
+    // moves their texture coordinate, not their position
+    float p = float(column);
+    if(ring == 0) p += 0.5;
+    else if(ring == segments) p -= 0.5;
+
+    Angles = vec2(ring, p) * PI / segments;
+}
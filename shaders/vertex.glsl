@@ -11,8 +11,15 @@
 layout(location = 0) in vec3 VertexPosition;
 layout(location = 1) in vec2 TextureCoord;
 
-uniform mat4 modelViewProjection;
-uniform mat4 modelMatrix;
+// per frame and per object uniform blocks, see uniformblocks.h
+layout(std140) uniform FrameBlock {
+    mat4 viewProjection;
+    vec3 camPosition;
+    float time;         // seconds since startup
+};
+layout(std140) uniform ObjectBlock {
+    mat4 modelMatrix;   // unit sphere to world, uniform scale
+};
 
 out vec2 Texcoord;
 out vec3 Vertexp;
@@ -29,6 +36,6 @@ void main()
     Vertexp.y = tmp.y;
     Vertexp.z = tmp.z;
     // assign vertex position without modification
-    gl_Position = modelViewProjection * modelMatrix * vec4(VertexPosition, 1.0);
+    gl_Position = viewProjection * modelMatrix * vec4(VertexPosition, 1.0);
     Texcoord = TextureCoord;
 }